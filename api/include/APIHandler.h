@@ -1,6 +1,7 @@
 #pragma once
 
 #include <csnode/Blockchain.hpp>
+#include <atomic>
 #include <mutex>
 
 #include <API.h>
@@ -44,8 +45,17 @@ using namespace ::apache;
 class APIHandler : public APIHandlerInterface
 {
   public:
-    APIHandler(Credits::BlockChain& blockchain, Credits::ISolver& _solver);
-    ~APIHandler() override = default;
+    typedef std::function<bool(const csdb::Transaction&)> Submit;
+
+    // Without a solver, the transactions go only to the submit
+    APIHandler(Credits::BlockChain& blockchain,
+               Credits::ISolver* _solver,
+               Submit submit = nullptr);
+    ~APIHandler() override;
+
+    // Reads the chain into the caches, the requests build them on demand
+    // until then
+    void warm_up();
 
     void BalanceGet(api::BalanceGetResult& _return,
                     const api::Address& address,
@@ -102,7 +112,10 @@ class APIHandler : public APIHandlerInterface
     void GetSmartContractAddress(const std::string& data,
                                  std::string& smartContractAddress);
 
-    Credits::ISolver& solver;
+    Credits::ISolver* solver;
+    Submit submit_transaction;
+
+    bool send_wallet_transaction(const csdb::Transaction& transaction);
 
     csstats::csstats stats;
 
@@ -136,5 +149,16 @@ class APIHandler : public APIHandlerInterface
 
     void update_smart_caches();
 
+    // The caches above are kept in the snapshot
+    void restore_smart_caches();
+    std::mutex smart_mutex;
+
+    // Estimated under smart_mutex, read by the memory budget
+    void count_smart_caches();
+    std::atomic<size_t> smart_caches_bytes{ 0 };
+
+    // Shrunk by the memory budget
+    void add_memory_parts();
     std::map<csdb::PoolHash, api::Pool> poolCache;
+    std::mutex pool_cache_mutex;
 };
\ No newline at end of file
@@ -4,19 +4,23 @@
 
 #include <thread>
 #include <memory>
+#include <functional>
 
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/server/TThreadedServer.h>
+#include <thrift/concurrency/PlatformThreadFactory.h>
 
 #include <csdb/storage.h>
+#include <csdb/transaction.h>
 #include <Solver/ISolver.hpp>
 
 using namespace ::apache::thrift;
 using namespace ::apache::thrift::protocol;
 using namespace ::apache::thrift::transport;
 using namespace ::apache::thrift::server;
+using namespace ::apache::thrift::concurrency;
 
 using namespace api;
 
@@ -24,6 +28,22 @@ namespace csconnector {
 
     struct Config {
         int port = 9090;
+        // Runs first on every client connection thread
+        std::function<void()> onClientThread;
+        // Hands a wallet transaction to the node, false if not taken. The
+        // solver is called by the API thread itself when not set
+        std::function<bool(const csdb::Transaction&)> submitTransaction;
+    };
+
+    // Thread factory running a hook before the client connection
+    class HookedThreadFactory : public PlatformThreadFactory {
+    public:
+        explicit HookedThreadFactory(std::function<void()> hook);
+
+        stdcxx::shared_ptr<Thread> newThread(stdcxx::shared_ptr<Runnable> runnable) const override;
+
+    private:
+        std::function<void()> hook;
     };
 
     class csconnector {
@@ -35,7 +55,13 @@ namespace csconnector {
 
         csconnector(const csconnector &) = delete;
         csconnector &operator=(const csconnector &)= delete;
+
+        std::thread::native_handle_type getThreadHandle() { return thread.native_handle(); }
+
+        // The API is served meanwhile
+        void warmUp() { handler->warm_up(); }
     private:
+        stdcxx::shared_ptr<APIHandler> handler;
         TThreadedServer server;
         std::thread thread;
     };
@@ -2,6 +2,7 @@
 #define CSSTATS_H
 
 #include <cstdint>
+#include <map>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -78,8 +79,13 @@ namespace csstats {
 
         StatsPerPeriod getStats();
 
+        // Until the whole chain is read the first time, or the stats are stopped
+        void waitFirstUpdate();
+
         ~csstats();
 
+        std::thread::native_handle_type getThreadHandle() { return thread.native_handle(); }
+
     private:
         std::thread thread;
 
@@ -92,10 +98,28 @@ namespace csstats {
 
         StatsPerPeriod currentStats;
         std::mutex currentStatsMutex;
+        bool updated = false;
+        std::condition_variable updatedCV;
         std::chrono::system_clock::time_point lastUpdateTime = std::chrono::system_clock::from_time_t(0);
 
         Credits::BlockChain &blockchain;
 
+        // The pools summed by the hour of their time, the ones older than the
+        // last periods but the longest one all together. Only the new blocks are
+        // read into them, and they are kept in the snapshot
+        struct Aggregates
+        {
+            csdb::PoolHash lastHash;
+            std::map<int64_t, PeriodStats> hours;
+            PeriodStats older;
+        };
+
+        Aggregates aggregates;
+        std::mutex aggregatesMutex;
+
+        void collectNewBlocks();
+        void restoreAggregates();
+
         StatsPerPeriod collectStats(const Periods &periods);
 
         template<class F>
@@ -25,10 +25,16 @@
 
 using namespace api;
 
+// With the tree nodes and the bytes of the keys
+const size_t smart_entry_bytes = 256;
+const size_t pool_entry_bytes = 512;
+
 APIHandler::APIHandler(Credits::BlockChain& blockchain,
-                       Credits::ISolver& _solver)
+                       Credits::ISolver* _solver,
+                       Submit submit)
   : s_blockchain(blockchain)
   , solver(_solver)
+  , submit_transaction(std::move(submit))
   , stats(blockchain)
   , executor_transport(new thrift::transport::TBufferedTransport(
       thrift::stdcxx::make_shared<thrift::transport::TSocket>("localhost",
@@ -42,7 +48,41 @@ APIHandler::APIHandler(Credits::BlockChain& blockchain,
     if (!s_blockchain.isGood()) {
         return;
     }
+    restore_smart_caches();
+    add_memory_parts();
+}
+
+APIHandler::~APIHandler()
+{
+    auto& budget = s_blockchain.getMemoryBudget();
+    budget.removePart("api pools");
+    budget.removePart("api smarts");
+}
+
+void
+APIHandler::warm_up()
+{
+    if (!s_blockchain.isGood()) {
+        return;
+    }
     update_smart_caches();
+    stats.waitFirstUpdate();
+}
+
+bool
+APIHandler::send_wallet_transaction(const csdb::Transaction& transaction)
+{
+    if (submit_transaction) {
+        return submit_transaction(transaction);
+    }
+
+    if (!solver) {
+        LOG_ERROR("solver == nullptr");
+        return false;
+    }
+
+    solver->send_wallet_transaction(transaction);
+    return true;
 }
 
 void
@@ -443,11 +483,10 @@ APIHandler::TransactionFlow(TransactionFlowResult& _return,
 
     SUPER_TIC();
 
-    if (&solver == nullptr) {
-        LOG_ERROR("solver == nullptr");
+    if (!send_wallet_transaction(send_transaction)) {
+        SetResponseStatus(_return.status, APIRequestStatusType::FAILURE);
         return;
     }
-    solver.send_wallet_transaction(send_transaction);
 
     SUPER_TIC();
 
@@ -488,7 +527,10 @@ APIHandler::TransactionFlow(TransactionFlowResult& _return,
 
     csdb::Transaction contract_redeploy_tr = send_transaction;
     contract_redeploy_tr.add_user_field(0, serialize(new_smart));
-    solver.send_wallet_transaction(contract_redeploy_tr);
+    if (!send_wallet_transaction(contract_redeploy_tr)) {
+        SetResponseStatus(_return.status, APIRequestStatusType::FAILURE);
+        return;
+    }
 
     SUPER_TIC();
 
@@ -518,9 +560,11 @@ APIHandler::PoolListGet(api::PoolListGetResult& _return,
     const uint64_t lower =
       sequence - std::min(sequence, (uint64_t)(offset + const_limit));
     for (uint64_t it = sequence; it > lower; --it) {
+        std::unique_lock<std::mutex> lock(pool_cache_mutex);
         auto cch = poolCache.find(hash);
 
         if (cch == poolCache.end()) {
+            lock.unlock();
             pool = s_blockchain.loadBlock(hash);
             api::Pool apiPool = convertPool(pool);
 
@@ -529,7 +573,8 @@ APIHandler::PoolListGet(api::PoolListGetResult& _return,
             }
             lastCount = 0;
 
-            poolCache.insert(cch, std::make_pair(hash, apiPool));
+            lock.lock();
+            poolCache.emplace(hash, apiPool);
             hash = pool.previous_hash();
         } else {
             _return.pools.push_back(cch->second);
@@ -630,9 +675,83 @@ APIHandler::SmartContractGet(api::SmartContractGetResult& _return,
     return;
 }
 
+void
+APIHandler::restore_smart_caches()
+{
+    auto& snapshot = s_blockchain.getSnapshot();
+
+    snapshot.restore("smarts", [this](Credits::SnapshotReader& in) {
+        decltype(smart_origin) origin, state;
+        decltype(deployed_by_creator) deployed;
+        csdb::PoolHash last_seen;
+
+        auto read_ids = [&in](decltype(smart_origin)& ids) {
+            uint64_t count = 0;
+            in >> count;
+            for (uint64_t i = 0; i < count && in.good(); ++i) {
+                api::Address address;
+                in >> address;
+                in >> ids[address];
+            }
+        };
+
+        uint64_t deployers = 0;
+        in >> last_seen;
+        read_ids(origin);
+        read_ids(state);
+        in >> deployers;
+
+        for (uint64_t i = 0; i < deployers && in.good(); ++i) {
+            csdb::Address deployer;
+            uint64_t count = 0;
+            in >> deployer >> count;
+
+            auto& ids = deployed[deployer];
+            for (uint64_t j = 0; j < count && in.good(); ++j) {
+                csdb::TransactionID id;
+                in >> id;
+                ids.push_back(id);
+            }
+        }
+
+        if (!in.good() || !in.end())
+            return false;
+
+        smart_origin = std::move(origin);
+        smart_state = std::move(state);
+        deployed_by_creator = std::move(deployed);
+        count_smart_caches();
+        last_seen_contract_block = last_seen;
+        return true;
+    });
+
+    snapshot.addPart("smarts", [this](Credits::SnapshotWriter& out) {
+        std::lock_guard<std::mutex> lock(smart_mutex);
+
+        auto write_ids = [&out](const decltype(smart_origin)& ids) {
+            out << (uint64_t)ids.size();
+            for (auto& id : ids)
+                out << id.first << id.second;
+        };
+
+        out << last_seen_contract_block;
+        write_ids(smart_origin);
+        write_ids(smart_state);
+
+        out << (uint64_t)deployed_by_creator.size();
+        for (auto& deployed : deployed_by_creator) {
+            out << deployed.first << (uint64_t)deployed.second.size();
+            for (auto& id : deployed.second)
+                out << id;
+        }
+    });
+}
+
 void
 APIHandler::update_smart_caches()
 {
+    std::lock_guard<std::mutex> lock(smart_mutex);
+
     std::map<csdb::Address, std::list<csdb::TransactionID>::iterator> poss;
     std::set<api::Address> state_updated;
     auto last_ph = s_blockchain.getLastHash();
@@ -667,6 +786,41 @@ APIHandler::update_smart_caches()
         curr_ph = p.previous_hash();
     }
     last_seen_contract_block = last_ph;
+    count_smart_caches();
+}
+
+void
+APIHandler::count_smart_caches()
+{
+    // Every deployed contract is in one of the lists
+    smart_caches_bytes = (smart_origin.size() * 2 + smart_state.size() +
+                          deployed_by_creator.size()) *
+                         smart_entry_bytes;
+}
+
+void
+APIHandler::add_memory_parts()
+{
+    auto& budget = s_blockchain.getMemoryBudget();
+
+    // Converted again from the storage
+    budget.addPart("api pools",
+                   Credits::MemoryBudget::Low,
+                   [this]() {
+                       std::lock_guard<std::mutex> lock(pool_cache_mutex);
+                       return poolCache.size() * pool_entry_bytes;
+                   },
+                   [this](size_t bytes) {
+                       std::lock_guard<std::mutex> lock(pool_cache_mutex);
+                       const size_t keep = bytes / pool_entry_bytes;
+                       while (poolCache.size() > keep)
+                           poolCache.erase(poolCache.begin());
+                   });
+
+    // Not shrunk, dropping an entry means walking the whole chain again
+    budget.addPart("api smarts", Credits::MemoryBudget::High, [this]() {
+        return smart_caches_bytes.load();
+    });
 }
 
 template<typename Mapper>
@@ -1,16 +1,73 @@
 #include "csconnector/csconnector.h"
 #include <csdb/currency.h>
+#include <csnode/PerfCounters.hpp>
+#include <thrift/TProcessor.h>
 
 namespace csconnector {
 
     using namespace stdcxx;
 
+    namespace {
+        class HookedRunnable : public Runnable {
+        public:
+            HookedRunnable(shared_ptr<Runnable> runnable, const std::function<void()> &hook)
+                : runnable(runnable), hook(hook) {}
+
+            void run() override {
+                hook();
+                runnable->run();
+            }
+
+            using Runnable::thread;
+            void thread(shared_ptr<Thread> value) override {
+                Runnable::thread(value);
+                runnable->thread(value);
+            }
+
+        private:
+            shared_ptr<Runnable> runnable;
+            std::function<void()> hook;
+        };
+
+        // Every call is a section of the API stage, on the thread serving it
+        class PerfEventHandler : public TProcessorEventHandler {
+        public:
+            void* getContext(const char*, void*) override {
+                return new Credits::PerfScope(Credits::PerfStage::Api);
+            }
+
+            void freeContext(void* ctx, const char*) override {
+                delete static_cast<Credits::PerfScope*>(ctx);
+            }
+        };
+
+        shared_ptr<APIProcessor> makeProcessor(shared_ptr<APIHandler> handler) {
+            auto processor = make_shared<APIProcessor>(handler);
+            if (Credits::PerfCounters::isEnabled())
+                processor->setEventHandler(make_shared<PerfEventHandler>());
+
+            return processor;
+        }
+    }
+
+    HookedThreadFactory::HookedThreadFactory(std::function<void()> hook)
+        : PlatformThreadFactory(false), hook(hook) {}
+
+    shared_ptr<Thread> HookedThreadFactory::newThread(shared_ptr<Runnable> runnable) const {
+        if (!hook)
+            return PlatformThreadFactory::newThread(runnable);
+
+        return PlatformThreadFactory::newThread(make_shared<HookedRunnable>(runnable, hook));
+    }
+
     csconnector::csconnector(Credits::BlockChain &m_blockchain, Credits::ISolver* solver, const Config &config)
-		: server(
-                    make_shared<APIProcessor>(make_shared<APIHandler>(m_blockchain, *solver)),
+		: handler(make_shared<APIHandler>(m_blockchain, solver, config.submitTransaction))
+		, server(
+                    makeProcessor(handler),
                     make_shared<TServerSocket>(config.port),
                     make_shared<TBufferedTransportFactory>(),
-                    make_shared<TBinaryProtocolFactory>())
+                    make_shared<TBinaryProtocolFactory>(),
+                    make_shared<HookedThreadFactory>(config.onClientThread))
 
     {
         thread = std::thread([this, config]() {
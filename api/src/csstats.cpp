@@ -5,6 +5,9 @@
 
 namespace csstats {
 
+// The pools are counted at the precision of an hour
+const int64_t secondsPerHour = 60 * 60;
+
 template<class F>
 void
 csstats::matchPeriod(const Periods& periods, uint32_t period, F func)
@@ -15,6 +18,149 @@ csstats::matchPeriod(const Periods& periods, uint32_t period, F func)
     }
 }
 
+static void
+addPool(PeriodStats& stats, const csdb::Pool& pool)
+{
+    stats.poolsCount++;
+
+    size_t transactionsCount = pool.transactions_count();
+    stats.transactionsCount += transactionsCount;
+    for (size_t i = 0; i < transactionsCount; ++i) {
+        const auto& transaction =
+          pool.transaction(csdb::TransactionID(pool.hash(), i));
+
+        if (transaction.user_field(0).is_valid())
+            ++stats.smartContractsCount;
+
+        Currency currency = transaction.currency().to_string();
+
+        const auto& amount = transaction.amount();
+
+        stats.balancePerCurrency[currency].integral += amount.integral();
+        stats.balancePerCurrency[currency].fraction += amount.fraction();
+    }
+}
+
+static void
+addStats(PeriodStats& to, const PeriodStats& from)
+{
+    to.poolsCount += from.poolsCount;
+    to.transactionsCount += from.transactionsCount;
+    to.smartContractsCount += from.smartContractsCount;
+
+    for (auto& balance : from.balancePerCurrency) {
+        auto& total = to.balancePerCurrency[balance.first];
+        total.integral += balance.second.integral;
+        total.fraction += balance.second.fraction;
+    }
+}
+
+static void
+writeStats(Credits::SnapshotWriter& out, const PeriodStats& stats)
+{
+    out << stats.poolsCount << stats.transactionsCount
+        << stats.smartContractsCount
+        << (uint32_t)stats.balancePerCurrency.size();
+
+    for (auto& balance : stats.balancePerCurrency)
+        out << balance.first << balance.second.integral
+            << balance.second.fraction;
+}
+
+static void
+readStats(Credits::SnapshotReader& in, PeriodStats& stats)
+{
+    uint32_t currencies = 0;
+    in >> stats.poolsCount >> stats.transactionsCount >>
+      stats.smartContractsCount >> currencies;
+
+    for (uint32_t i = 0; i < currencies && in.good(); ++i) {
+        Currency currency;
+        in >> currency;
+
+        auto& total = stats.balancePerCurrency[currency];
+        in >> total.integral >> total.fraction;
+    }
+}
+
+void
+csstats::collectNewBlocks()
+{
+    csdb::PoolHash lastHash;
+    {
+        ScopedLock lock(aggregatesMutex);
+        lastHash = aggregates.lastHash;
+    }
+
+    std::map<int64_t, PeriodStats> added;
+
+    const auto tipHash = blockchain.getLastHash();
+    auto blockHash = tipHash;
+
+    while (!blockHash.is_empty() && blockHash != lastHash) {
+        if (quit)
+            return;
+
+        const csdb::Pool pool = blockchain.loadBlock(blockHash);
+
+        auto poolTime_t =
+          atoll(pool.user_field(0).value<std::string>().c_str()) / 1000;
+        addPool(added[poolTime_t / secondsPerHour], pool);
+
+        blockHash = pool.previous_hash();
+    }
+
+    ScopedLock lock(aggregatesMutex);
+
+    // The last block read is not in the chain any more, all of it is read again
+    if (blockHash.is_empty() && !lastHash.is_empty())
+        aggregates = Aggregates();
+
+    for (auto& hour : added)
+        addStats(aggregates.hours[hour.first], hour.second);
+
+    aggregates.lastHash = tipHash;
+}
+
+void
+csstats::restoreAggregates()
+{
+    auto& snapshot = blockchain.getSnapshot();
+
+    snapshot.restore("stats", [this](Credits::SnapshotReader& in) {
+        Aggregates restored;
+        uint64_t count = 0;
+        in >> restored.lastHash >> count;
+
+        for (uint64_t i = 0; i < count && in.good(); ++i) {
+            int64_t hour = 0;
+            in >> hour;
+            readStats(in, restored.hours[hour]);
+        }
+
+        readStats(in, restored.older);
+
+        if (!in.good() || !in.end())
+            return false;
+
+        aggregates = std::move(restored);
+        return true;
+    });
+
+    // The node and the API have the same stats, the first one is saved
+    snapshot.addPart("stats", [this](Credits::SnapshotWriter& out) {
+        ScopedLock lock(aggregatesMutex);
+
+        out << aggregates.lastHash << (uint64_t)aggregates.hours.size();
+        for (auto& hour : aggregates.hours) {
+            out << hour.first;
+            writeStats(out, hour.second);
+        }
+
+        writeStats(out, aggregates.older);
+    });
+}
+
 StatsPerPeriod
 csstats::collectStats(const Periods& periods)
 {
@@ -27,6 +173,8 @@ csstats::collectStats(const Periods& periods)
 
     auto startTime = std::chrono::high_resolution_clock::now();
 
+    collectNewBlocks();
+
     StatsPerPeriod stats;
     for (auto& period : periods) {
         PeriodStats p;
@@ -35,55 +183,36 @@ csstats::collectStats(const Periods& periods)
         stats.push_back(p);
     }
 
-    std::string prevHash;
+    const int64_t now =
+      std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
-    auto blockHash = blockchain.getLastHash();
+    // The longest period takes all of the older pools
+    const Period horizon = periods.size() > 1 ? periods[periods.size() - 2] : 0;
 
-    while (!blockHash.is_empty() && !quit) {
-        typedef std::vector<csdb::Transaction> Transactions;
-        Transactions transactions;
+    {
+        ScopedLock lock(aggregatesMutex);
 
-        time_t timeMs = 0;
+        auto& hours = aggregates.hours;
+        for (auto hour = hours.begin(); hour != hours.end();) {
+            const int64_t hourAgeSec = now - hour->first * secondsPerHour;
 
-        const csdb::Pool pool = blockchain.loadBlock(blockHash);
-
-        time_t timeSec = timeMs / 1000;
-
-        auto now = std::chrono::system_clock::now();
-        auto poolTime_t =
-          atoll(pool.user_field(0).value<std::string>().c_str()) / 1000;
-        auto poolTime = std::chrono::system_clock::from_time_t(poolTime_t);
-
-        using Seconds = std::chrono::seconds;
-        Seconds poolAgeSec =
-          std::chrono::duration_cast<Seconds>(now - poolTime);
-
-        matchPeriod(
-          periods, (Period)poolAgeSec.count(), [&](size_t periodIndex) {
-              PeriodStats& periodStats = stats[periodIndex];
-              periodStats.poolsCount++;
-
-              size_t transactionsCount = pool.transactions_count();
-              periodStats.transactionsCount += transactionsCount;
-              for (size_t i = 0; i < transactionsCount; ++i) {
-                  const auto& transaction =
-                    pool.transaction(csdb::TransactionID(pool.hash(), i));
-
-                  if (transaction.user_field(0).is_valid())
-                      ++periodStats.smartContractsCount;
-
-                  Currency currency = transaction.currency().to_string();
-
-                  const auto& amount = transaction.amount();
+            if (hourAgeSec > horizon + secondsPerHour) {
+                addStats(aggregates.older, hour->second);
+                hour = hours.erase(hour);
+                continue;
+            }
 
-                  periodStats.balancePerCurrency[currency].integral +=
-                    amount.integral();
-                  periodStats.balancePerCurrency[currency].fraction +=
-                    amount.fraction();
-              }
-          });
+            matchPeriod(periods,
+                        (Period)std::max<int64_t>(hourAgeSec, 0),
+                        [&](size_t periodIndex) {
+                            addStats(stats[periodIndex], hour->second);
+                        });
+            ++hour;
+        }
 
-        blockHash = pool.previous_hash();
+        matchPeriod(periods, horizon, [&](size_t periodIndex) {
+            addStats(stats[periodIndex], aggregates.older);
+        });
     }
 
     auto finishTime = std::chrono::high_resolution_clock::now();
@@ -107,6 +236,8 @@ csstats::csstats(Credits::BlockChain& blockchain, const Config& config)
 
     ScopedLock lock(mutex);
 
+    restoreAggregates();
+
     thread = std::thread([=]() {
         Log("csstats thread started");
 
@@ -150,7 +281,9 @@ csstats::csstats(Credits::BlockChain& blockchain, const Config& config)
                 {
                     ScopedLock lock(currentStatsMutex);
                     currentStats = std::move(stats);
+                    updated = true;
                 }
+                updatedCV.notify_all();
 
                 lastUpdateTime = std::chrono::system_clock::now();
             }
@@ -169,6 +302,11 @@ csstats::~csstats()
     quit = true;
     quitCV.notify_all();
 
+    {
+        ScopedLock lock(currentStatsMutex);
+    }
+    updatedCV.notify_all();
+
     if (thread.joinable())
         thread.join();
 }
@@ -179,4 +317,11 @@ csstats::getStats()
     ScopedLock lock(currentStatsMutex);
     return currentStats;
 }
+
+void
+csstats::waitFirstUpdate()
+{
+    std::unique_lock<std::mutex> lock(currentStatsMutex);
+    updatedCV.wait(lock, [this]() { return updated || quit; });
+}
 }
@@ -111,21 +111,14 @@ namespace cscrypto
 
     Signature signature;
 
-    Context& context = getContext();
-
-    {
-      ScopedLock lock(context.mutex);
-      ed25519_sign(signature.data(), hash.data(), hash.size(), keyPair.publicKey.data(), keyPair.privateKey.data());
-    }
+    // Signing and verification touch no shared state, only the seed needs the lock
+    ed25519_sign(signature.data(), hash.data(), hash.size(), keyPair.publicKey.data(), keyPair.privateKey.data());
 
     return signature;
   }
 
   bool verify(const PublicKey& publicKey, const Hash& hash, const Signature& signature)
   {
-    Context& context = getContext();
-    ScopedLock lock(context.mutex);
-
     return ed25519_verify(signature.data(), hash.data(), hash.size(), publicKey.data()) == 1;
   }
 }
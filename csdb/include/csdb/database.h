@@ -61,6 +61,11 @@ public:
   using IteratorPtr = std::shared_ptr<Iterator>;
   virtual IteratorPtr new_iterator() = 0;
 
+  // Bytes of the cache of the database, resized while open. A database without
+  // a cache of its own has none, and fails to resize it with NotSupported.
+  virtual size_t cache_size();
+  virtual bool set_cache_size(size_t bytes);
+
 public:
   Error last_error() const;
   std::string last_error_message() const;
@@ -31,6 +31,8 @@ private:
   bool remove(const byte_array &key) override final;
   bool write_batch(const ItemList &items) override final;
   IteratorPtr new_iterator() override final;
+  size_t cache_size() override final;
+  bool set_cache_size(size_t bytes) override final;
 
 private:
   class Iterator;
@@ -11,6 +11,34 @@ namespace internal {
 
 using byte_array = std::vector<std::uint8_t>;
 
+//Bytes inside a buffer owned by someone else
+struct byte_view
+{
+  const std::uint8_t* data = nullptr;
+  size_t size = 0;
+
+  inline byte_array to_array() const { return byte_array(data, data + size); }
+};
+
+//Destination of the serialized data, which is written piece by piece
+class byte_sink
+{
+public:
+  virtual ~byte_sink() = default;
+  virtual void write(const void* data, size_t size) = 0;
+};
+
+//Counts the bytes, for a serialized size without the bytes themselves
+class byte_counter : public byte_sink
+{
+public:
+  void write(const void*, size_t size) override { size_ += size; }
+  size_t size() const noexcept { return size_; }
+
+private:
+  size_t size_ = 0;
+};
+
 } // namespace internal
 } // namespace csdb
 
@@ -68,6 +68,10 @@ public:
 
   static Pool from_byte_stream(const char* data, size_t size);
   char* to_byte_stream(uint32_t&);
+
+  //Same bytes, written straight into the sink. The cached representation is
+  //used if there is one, none is made otherwise
+  void to_byte_stream(::csdb::internal::byte_sink& sink) const;
   ::csdb::internal::byte_array to_byte_stream_for_sig();
 
   Pool meta_from_byte_stream(const char*, size_t);
@@ -134,7 +138,13 @@ public:
   void sign(std::vector<uint8_t> private_key);
   bool verify_signature();
 
+private:
+  //The pool of the bytes, with its transactions already read from them up to the tail
+  static Pool from_byte_stream(const char* data, size_t size, std::vector<Transaction>&& transactions,
+                               size_t tail);
+
   friend class Storage;
+  friend class PoolReader;
 };
 
 inline bool PoolHash::operator !=(const PoolHash &other) const noexcept
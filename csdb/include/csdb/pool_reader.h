@@ -0,0 +1,48 @@
+#pragma once
+#ifndef _CREDITS_CSDB_POOL_READER_H_INCLUDED_
+#define _CREDITS_CSDB_POOL_READER_H_INCLUDED_
+
+#include <cinttypes>
+#include <vector>
+
+#include "csdb/pool.h"
+#include "csdb/transaction.h"
+
+namespace csdb {
+
+//Reads a serialized pool fed in pieces, in order, e.g. as the packets of a message
+//arrive. Every transaction is built as soon as all its bytes are in, so at the end
+//only the tail of the pool and its hash are left
+class PoolReader
+{
+public:
+  //Expected size of the whole pool, to avoid copying the bytes on growth
+  void reserve(size_t size);
+
+  //Appends the next piece and reads whatever is complete
+  void feed(const char* data, size_t size);
+
+  bool is_header_read() const noexcept { return header_read_; }
+  size_t transactions_count() const noexcept { return transactions_count_; }
+  size_t transactions_read() const noexcept { return transactions_.size(); }
+  size_t bytes_fed() const noexcept { return buffer_.size(); }
+
+  //Builds the pool, the bytes fed have to make exactly one
+  bool finish(Pool& pool);
+
+  void clear();
+
+private:
+  void read();
+
+  ::std::vector<char> buffer_;
+  size_t pos_ = 0;  //Read up to
+
+  bool header_read_ = false;
+  size_t transactions_count_ = 0;
+  ::std::vector<Transaction> transactions_;
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_POOL_READER_H_INCLUDED_
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef _CREDITS_CSDB_POOL_VIEW_H_INCLUDED_
+#define _CREDITS_CSDB_POOL_VIEW_H_INCLUDED_
+
+#include <cinttypes>
+#include <iterator>
+
+#include "csdb/transaction_view.h"
+#include "csdb/internal/types.h"
+
+namespace csdb {
+
+class Pool;
+
+//Read-only pool over its serialized bytes. Parsing checks every transaction in place,
+//without copies and allocations. The buffer must outlive the view
+class PoolView
+{
+public:
+  class const_iterator
+  {
+  public:
+    using iterator_category = ::std::forward_iterator_tag;
+    using value_type = TransactionView;
+    using difference_type = ::std::ptrdiff_t;
+    using pointer = const TransactionView*;
+    using reference = const TransactionView&;
+
+    const_iterator() = default;
+
+    reference operator *() const noexcept { return view_; }
+    pointer operator ->() const noexcept { return &view_; }
+
+    const_iterator& operator ++() noexcept;
+    const_iterator operator ++(int) noexcept;
+
+    bool operator ==(const const_iterator& other) const noexcept { return pos_ == other.pos_; }
+    bool operator !=(const const_iterator& other) const noexcept { return pos_ != other.pos_; }
+
+  private:
+    const_iterator(const char* pos, const char* end) noexcept;
+
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    TransactionView view_;
+
+    friend class PoolView;
+  };
+
+  //Parses the pool at the beginning of the buffer, the rest is not looked at
+  bool parse(const char* data, size_t size) noexcept;
+
+  const char* data() const noexcept { return data_; }
+
+  //Bytes the pool takes in the buffer
+  size_t binary_size() const noexcept { return size_; }
+
+  ::csdb::internal::byte_view previous_hash() const noexcept { return previous_hash_; }
+  uint64_t sequence() const noexcept { return sequence_; }
+  size_t user_fields_count() const noexcept { return user_fields_count_; }
+  size_t transactions_count() const noexcept { return transactions_count_; }
+  ::csdb::internal::byte_view writer_public_key() const noexcept { return writer_public_key_; }
+  ::csdb::internal::byte_view signature() const noexcept { return signature_; }
+
+  const_iterator begin() const noexcept { return const_iterator(transactions_begin_, transactions_end_); }
+  const_iterator end() const noexcept { return const_iterator(transactions_end_, transactions_end_); }
+
+  //Builds the full pool, with its hash
+  Pool to_pool() const;
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+
+  ::csdb::internal::byte_view previous_hash_;
+  uint64_t sequence_ = 0;
+  size_t user_fields_count_ = 0;
+  size_t transactions_count_ = 0;
+  const char* transactions_begin_ = nullptr;
+  const char* transactions_end_ = nullptr;
+  ::csdb::internal::byte_view writer_public_key_;
+  ::csdb::internal::byte_view signature_;
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_POOL_VIEW_H_INCLUDED_
@@ -6,6 +6,7 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <thread>
 
 #include "csdb/transaction.h"
 #include "csdb/database.h"
@@ -92,6 +93,9 @@ public:
   //Closing storage
   void close();
 
+  //Native handle of the thread writing pools to the database, for affinity and priority
+  ::std::thread::native_handle_type write_thread_handle() const;
+
   //Last block hash
   PoolHash last_hash() const noexcept;
   void set_last_hash(const PoolHash&) noexcept;
@@ -116,6 +120,10 @@ public:
   //size returns the number of pools in the storage.
   size_t size() const noexcept;
 
+  //Bytes of the database cache, and its resizing while the storage is open
+  size_t cache_size() const;
+  bool set_cache_size(size_t bytes);
+
   //Get a wallet for the specified address
   Wallet wallet(const Address &addr) const;
 
@@ -97,8 +97,12 @@ public:
 
   static Transaction from_byte_stream(const char* data, size_t m_size);
   std::vector<uint8_t> to_byte_stream() const;
+  void to_byte_stream(::csdb::internal::byte_sink& sink) const;
   std::vector<uint8_t> to_byte_stream_for_sig() const;
 
+  //Checks the signature of the source over to_byte_stream_for_sig()
+  bool verify_signature() const;
+
   //Adds an optional extra field to the transaction
   bool add_user_field(user_field_id_t id, UserField field) noexcept;
 
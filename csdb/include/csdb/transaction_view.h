@@ -0,0 +1,62 @@
+#pragma once
+#ifndef _CREDITS_CSDB_TRANSACTION_VIEW_H_INCLUDED_
+#define _CREDITS_CSDB_TRANSACTION_VIEW_H_INCLUDED_
+
+#include <cinttypes>
+
+#include "csdb/amount.h"
+#include "csdb/internal/types.h"
+
+namespace csdb {
+
+class Transaction;
+
+//Read-only transaction over its serialized bytes. Parsing takes no copies and no
+//allocations, the buffer must outlive the view
+class TransactionView
+{
+public:
+  //Parses the transaction at the beginning of the buffer, the rest is not looked at
+  bool parse(const char* data, size_t size) noexcept;
+
+  //Same checks as Transaction::is_valid()
+  bool is_valid() const noexcept;
+
+  const char* data() const noexcept { return data_; }
+
+  //Bytes the transaction takes in the buffer
+  size_t binary_size() const noexcept { return size_; }
+
+  int64_t innerID() const noexcept { return innerID_; }
+  ::csdb::internal::byte_view source() const noexcept { return source_; }
+  ::csdb::internal::byte_view target() const noexcept { return target_; }
+  ::csdb::internal::byte_view currency() const noexcept { return currency_; }
+  Amount amount() const noexcept { return amount_; }
+  Amount max_fee() const noexcept { return max_fee_; }
+  Amount counted_fee() const noexcept { return counted_fee_; }
+  size_t user_fields_count() const noexcept { return user_fields_count_; }
+  ::csdb::internal::byte_view signature() const noexcept { return signature_; }
+  Amount balance() const noexcept { return balance_; }
+
+  //Builds the full transaction
+  Transaction to_transaction() const;
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+
+  int64_t innerID_ = 0;
+  ::csdb::internal::byte_view source_;
+  ::csdb::internal::byte_view target_;
+  ::csdb::internal::byte_view currency_;
+  Amount amount_;
+  Amount max_fee_;
+  Amount counted_fee_;
+  size_t user_fields_count_ = 0;
+  ::csdb::internal::byte_view signature_;
+  Amount balance_;
+};
+
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_TRANSACTION_VIEW_H_INCLUDED_
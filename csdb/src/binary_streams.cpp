@@ -7,20 +7,19 @@ namespace priv {
 
 void obstream::put(const void *buf, size_t size)
 {
-  const uint8_t *data = reinterpret_cast<const uint8_t*>(buf);
-  buffer_.insert(buffer_.end(), data, data + size);
+  write(buf, size);
 }
 
 void obstream::put(const std::string &value)
 {
   put(static_cast<uint32_t>(value.size()));
-  buffer_.insert(buffer_.end(), value.begin(), value.end());
+  write(value.data(), value.size());
 }
 
 void obstream::put(const internal::byte_array &value)
 {
   put(value.size());
-  buffer_.insert(buffer_.end(), value.begin(), value.end());
+  write(value.data(), value.size());
 }
 
 bool ibstream::get(void *buf, size_t size)
@@ -36,6 +35,17 @@ bool ibstream::get(void *buf, size_t size)
   return true;
 }
 
+bool ibstream::skip(size_t size)
+{
+  if (size > size_) {
+    return false;
+  }
+
+  size_ -= size;
+  data_ = static_cast<const uint8_t*>(data_) + size;
+  return true;
+}
+
 bool ibstream::get(std::string &value)
 {
   uint32_t size;
@@ -70,5 +80,29 @@ bool ibstream::get(internal::byte_array &value)
   return true;
 }
 
+bool ibstream::get_view(internal::byte_view &value)
+{
+  size_t size;
+  if (!get(size)) {
+    return false;
+  }
+
+  value.data = static_cast<const uint8_t*>(data_);
+  value.size = size;
+  return skip(size);
+}
+
+bool ibstream::get_string_view(internal::byte_view &value)
+{
+  uint32_t size;
+  if (!get(size)) {
+    return false;
+  }
+
+  value.data = static_cast<const uint8_t*>(data_);
+  value.size = size;
+  return skip(size);
+}
+
 } // namespace priv
 } // namespace csdb
@@ -17,6 +17,11 @@ namespace priv {
 class obstream
 {
 public:
+  obstream() = default;
+
+  //Writes to the sink instead of the own buffer
+  explicit obstream(internal::byte_sink* sink) : sink_(sink) {}
+
   void put(const void *buf, size_t size);
   void put(const std::string &value);
   void put(const internal::byte_array &value);
@@ -38,7 +43,19 @@ public:
   inline const internal::byte_array &buffer() const { return buffer_; }
 
 private:
+  inline void write(const void *buf, size_t size)
+  {
+    if (sink_) {
+      sink_->write(buf, size);
+    }
+    else {
+      const uint8_t *data = reinterpret_cast<const uint8_t*>(buf);
+      buffer_.insert(buffer_.end(), data, data + size);
+    }
+  }
+
   internal::byte_array buffer_;
+  internal::byte_sink* sink_ = nullptr;
 };
 
 class ibstream
@@ -53,6 +70,10 @@ public:
   bool get(std::string &value);
   bool get(internal::byte_array &value);
 
+  //Same layouts as the byte_array and the string, without copying the bytes
+  bool get_view(internal::byte_view &value);
+  bool get_string_view(internal::byte_view &value);
+
   template<typename T>
   typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, bool>::type
   get(T& value);
@@ -74,6 +95,14 @@ public:
     return (0 == size_);
   }
 
+  //Current position, for parsing in place
+  inline const void* data() const noexcept
+  {
+    return data_;
+  }
+
+  bool skip(size_t size);
+
 private:
   const void* data_;
   size_t size_;
@@ -89,8 +118,7 @@ template<typename T>
 typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, void>::type
 inline obstream::put(T value)
 {
-  buffer_.insert(buffer_.end(), reinterpret_cast<uint8_t *>(&value),
-    reinterpret_cast<uint8_t *>(&value) + sizeof(value));
+  write(&value, sizeof(value));
 }
 
 template<typename T>
@@ -34,6 +34,17 @@ Database::Iterator::~Iterator()
 {
 }
 
+size_t Database::cache_size()
+{
+  return 0;
+}
+
+bool Database::set_cache_size(size_t)
+{
+  set_last_error(NotSupported);
+  return false;
+}
+
 Database::Error Database::last_error() const
 {
   return last_error_map(this).last_error_;
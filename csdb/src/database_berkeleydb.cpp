@@ -235,6 +235,50 @@ bool DatabaseBerkeleyDB::write_batch(const ItemList &items)
   return true;
 }
 
+size_t DatabaseBerkeleyDB::cache_size()
+{
+  if (!db_blocks_) {
+    return 0;
+  }
+
+  u_int32_t gbytes = 0;
+  u_int32_t bytes = 0;
+  int ncache = 0;
+  if (env_.get_cachesize(&gbytes, &bytes, &ncache)) {
+    return 0;
+  }
+
+  return (static_cast<size_t>(gbytes) << 30) + bytes;
+}
+
+bool DatabaseBerkeleyDB::set_cache_size(size_t bytes)
+{
+  if (!db_blocks_) {
+    set_last_error(NotOpen);
+    return false;
+  }
+
+  u_int32_t gbytes = 0;
+  u_int32_t current = 0;
+  int ncache = 0;
+  int status = env_.get_cachesize(&gbytes, &current, &ncache);
+  if (status) {
+    set_last_error_from_berkeleydb(status);
+    return false;
+  }
+
+  // Resized in place, keeping the number of regions
+  status = env_.set_cachesize(static_cast<u_int32_t>(bytes >> 30),
+                              static_cast<u_int32_t>(bytes & ((1u << 30) - 1)), ncache);
+  if (status) {
+    set_last_error_from_berkeleydb(status);
+    return false;
+  }
+
+  set_last_error();
+  return true;
+}
+
 class DatabaseBerkeleyDB::Iterator final : public Database::Iterator
 {
 public:
@@ -510,6 +510,41 @@ Pool Pool::meta_from_binary(const ::csdb::internal::byte_array& data, size_t& cn
 	return Pool(p);
 }
 
+Pool Pool::from_byte_stream(const char* data, size_t size) {
+  priv *p = new priv();
+  ::csdb::priv::ibstream is(data, size);
+
+  if (!p->get(is)) {
+    delete p;
+    return Pool();
+  }
+
+  p->binary_representation_.assign(data, data + size);
+  p->hash_ = PoolHash::calc_from_data(p->binary_representation_);
+
+  return Pool(p);
+}
+
+Pool Pool::from_byte_stream(const char* data, size_t size, std::vector<Transaction>&& transactions,
+                            size_t tail) {
+  priv *p = new priv();
+  ::csdb::priv::ibstream is(data, size);
+  ::csdb::priv::ibstream tail_is(data + tail, size - tail);
+
+  size_t cnt;
+  if (!p->get_meta(is, cnt) || (cnt != transactions.size()) ||
+      !tail_is.get(p->writer_public_key_) || !tail_is.get(p->signature_)) {
+    delete p;
+    return Pool();
+  }
+
+  p->transactions_ = std::move(transactions);
+  p->binary_representation_.assign(data, data + size);
+  p->hash_ = PoolHash::calc_from_data(p->binary_representation_);
+
+  return Pool(p);
+}
+
 Pool Pool::meta_from_byte_stream(const char* data, size_t size) {
   priv *p = new priv();
   ::csdb::priv::ibstream is(data, size);
@@ -559,6 +594,18 @@ Pool Pool::from_lz4_byte_stream(const char* data, size_t size, size_t uncompress
 	  return (char*)(d->binary_representation_.data());
   }
 
+void Pool::to_byte_stream(::csdb::internal::byte_sink& sink) const
+{
+  const priv* data = d.constData();
+  if (!data->binary_representation_.empty()) {
+    sink.write(data->binary_representation_.data(), data->binary_representation_.size());
+    return;
+  }
+
+  ::csdb::priv::obstream os(&sink);
+  data->put(os);
+}
+
   bool Pool::save(Storage storage)
 {
   //if ((!d.constData()->is_valid_) || ((!d.constData()->read_only_))) {
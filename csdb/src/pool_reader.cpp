@@ -0,0 +1,75 @@
+#include "csdb/pool_reader.h"
+
+#include "csdb/transaction_view.h"
+
+#include "binary_streams.h"
+#include "view_p.h"
+
+namespace csdb {
+
+void PoolReader::reserve(size_t size)
+{
+  buffer_.reserve(size);
+}
+
+void PoolReader::feed(const char* data, size_t size)
+{
+  buffer_.insert(buffer_.end(), data, data + size);
+  read();
+}
+
+void PoolReader::read()
+{
+  //An incomplete part fails to parse and is tried again with the next piece
+  if (!header_read_) {
+    ::csdb::priv::ibstream is(buffer_.data(), buffer_.size());
+    ::csdb::internal::byte_view previous_hash;
+    uint64_t sequence;
+    size_t user_fields_count;
+
+    if (!(is.get_view(previous_hash) && is.get(sequence) &&
+          ::csdb::priv::skip_user_fields(is, user_fields_count) && is.get(transactions_count_))) {
+      return;
+    }
+
+    header_read_ = true;
+    pos_ = buffer_.size() - is.size();
+  }
+
+  TransactionView view;
+  while (transactions_.size() < transactions_count_ &&
+         view.parse(buffer_.data() + pos_, buffer_.size() - pos_)) {
+    transactions_.push_back(view.to_transaction());
+    pos_ += view.binary_size();
+  }
+}
+
+bool PoolReader::finish(Pool& pool)
+{
+  if (!header_read_ || transactions_.size() != transactions_count_) {
+    return false;
+  }
+
+  ::csdb::priv::ibstream is(buffer_.data() + pos_, buffer_.size() - pos_);
+  ::csdb::internal::byte_view writer_public_key;
+  ::csdb::internal::byte_view signature;
+  if (!(is.get_view(writer_public_key) && is.get_string_view(signature) && is.empty())) {
+    return false;
+  }
+
+  pool = Pool::from_byte_stream(buffer_.data(), buffer_.size(), std::move(transactions_), pos_);
+  clear();
+
+  return pool.is_valid();
+}
+
+void PoolReader::clear()
+{
+  buffer_.clear();
+  pos_ = 0;
+  header_read_ = false;
+  transactions_count_ = 0;
+  transactions_.clear();
+}
+
+} // namespace csdb
@@ -0,0 +1,75 @@
+#include "csdb/pool_view.h"
+
+#include "csdb/pool.h"
+
+#include "binary_streams.h"
+#include "view_p.h"
+
+namespace csdb {
+
+PoolView::const_iterator::const_iterator(const char* pos, const char* end) noexcept :
+  pos_(pos),
+  end_(end)
+{
+  if (pos_ != end_) {
+    view_.parse(pos_, end_ - pos_);
+  }
+}
+
+PoolView::const_iterator& PoolView::const_iterator::operator ++() noexcept
+{
+  //The transactions were checked by PoolView::parse()
+  pos_ += view_.binary_size();
+  if (pos_ != end_) {
+    view_.parse(pos_, end_ - pos_);
+  }
+  return *this;
+}
+
+PoolView::const_iterator PoolView::const_iterator::operator ++(int) noexcept
+{
+  const_iterator res = *this;
+  ++(*this);
+  return res;
+}
+
+bool PoolView::parse(const char* data, size_t size) noexcept
+{
+  *this = PoolView();
+
+  ::csdb::priv::ibstream is(data, size);
+  if (!(is.get_view(previous_hash_) && is.get(sequence_) &&
+        ::csdb::priv::skip_user_fields(is, user_fields_count_) && is.get(transactions_count_))) {
+    *this = PoolView();
+    return false;
+  }
+
+  transactions_begin_ = static_cast<const char*>(is.data());
+
+  TransactionView tran;
+  for (size_t i = 0; i < transactions_count_; ++i) {
+    if (!tran.parse(static_cast<const char*>(is.data()), is.size())) {
+      *this = PoolView();
+      return false;
+    }
+    is.skip(tran.binary_size());
+  }
+
+  transactions_end_ = static_cast<const char*>(is.data());
+
+  if (!(is.get_view(writer_public_key_) && is.get_string_view(signature_))) {
+    *this = PoolView();
+    return false;
+  }
+
+  data_ = data;
+  size_ = size - is.size();
+  return true;
+}
+
+Pool PoolView::to_pool() const
+{
+  return (nullptr == data_) ? Pool() : Pool::from_byte_stream(data_, size_);
+}
+
+} // namespace csdb
@@ -354,6 +354,11 @@ bool Storage::isOpen() const
   return ((d->db) && (d->db->is_open()));
 }
 
+::std::thread::native_handle_type Storage::write_thread_handle() const
+{
+  return d->write_thread.native_handle();
+}
+
 void Storage::set_last_hash(const csdb::PoolHash& h) noexcept
 {
   d->last_hash = h;
@@ -374,6 +379,27 @@ size_t Storage::size() const noexcept
   return d->count_pool;
 }
 
+size_t Storage::cache_size() const
+{
+  return isOpen() ? d->db->cache_size() : 0;
+}
+
+bool Storage::set_cache_size(size_t bytes)
+{
+  if (!isOpen()) {
+    d->set_last_error(NotOpen);
+    return false;
+  }
+
+  if (!d->db->set_cache_size(bytes)) {
+    d->set_last_error(DatabaseError);
+    return false;
+  }
+
+  d->set_last_error();
+  return true;
+}
+
 bool Storage::pool_save(Pool pool)
 {
   if (!isOpen()) {
@@ -5,6 +5,8 @@
 #include <iomanip>
 #include <sstream>
 
+#include <sodium.h>
+
 #include "binary_streams.h"
 #include "csdb/address.h"
 #include "csdb/amount.h"
@@ -362,6 +364,13 @@ Transaction::to_byte_stream() const
   return os.buffer();
 }
 
+void
+Transaction::to_byte_stream(::csdb::internal::byte_sink& sink) const
+{
+  ::csdb::priv::obstream os(&sink);
+  put(os);
+}
+
 std::vector<uint8_t>
 Transaction::to_byte_stream_for_sig() const
 {
@@ -393,6 +402,21 @@ Transaction::to_byte_stream_for_sig() const
   }
 }
 
+bool
+Transaction::verify_signature() const
+{
+  const priv* data = d.constData();
+  const auto key = data->source_.public_key();
+  if (key.size() != crypto_sign_ed25519_PUBLICKEYBYTES ||
+      data->signature_.size() != crypto_sign_ed25519_BYTES) {
+    return false;
+  }
+
+  const auto bytes = to_byte_stream_for_sig();
+  return crypto_sign_ed25519_verify_detached(reinterpret_cast<const uint8_t*>(data->signature_.data()),
+                                             bytes.data(), bytes.size(), key.data()) == 0;
+}
+
 void
 Transaction::put(::csdb::priv::obstream& os) const
 {
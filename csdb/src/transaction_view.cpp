@@ -0,0 +1,44 @@
+#include "csdb/transaction_view.h"
+
+#include <algorithm>
+
+#include "csdb/transaction.h"
+
+#include "binary_streams.h"
+#include "priv_crypto.h"
+#include "view_p.h"
+
+namespace csdb {
+
+bool TransactionView::parse(const char* data, size_t size) noexcept
+{
+  *this = TransactionView();
+
+  ::csdb::priv::ibstream is(data, size);
+  if (!(is.get(innerID_) && is.get_view(source_) && is.get_view(target_) &&
+        is.get_string_view(currency_) && is.get(amount_) && is.get(max_fee_) &&
+        is.get(counted_fee_) && ::csdb::priv::skip_user_fields(is, user_fields_count_) &&
+        is.get_string_view(signature_) && is.get(balance_))) {
+    *this = TransactionView();
+    return false;
+  }
+
+  data_ = data;
+  size_ = size - is.size();
+  return true;
+}
+
+bool TransactionView::is_valid() const noexcept
+{
+  const size_t key_size = ::csdb::priv::crypto::public_key_size;
+  return (nullptr != data_) && (key_size == source_.size) && (key_size == target_.size) &&
+         (0 != currency_.size) && (amount_ >= 0_c) &&
+         !std::equal(source_.data, source_.data + key_size, target_.data);
+}
+
+Transaction TransactionView::to_transaction() const
+{
+  return (nullptr == data_) ? Transaction() : Transaction::from_byte_stream(data_, size_);
+}
+
+} // namespace csdb
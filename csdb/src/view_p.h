@@ -0,0 +1,61 @@
+#pragma once
+#ifndef _CREDITS_CSDB_VIEW_PRIVATE_H_INCLUDED_
+#define _CREDITS_CSDB_VIEW_PRIVATE_H_INCLUDED_
+
+#include "csdb/amount.h"
+#include "csdb/user_field.h"
+
+#include "binary_streams.h"
+
+namespace csdb {
+namespace priv {
+
+//Walks over the user fields map written by obstream::put, returns their number
+inline bool skip_user_fields(ibstream& is, size_t& count)
+{
+  if (!is.get(count)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    user_field_id_t id;
+    UserField::Type type;
+    if (!is.get(id) || !is.get(type)) {
+      return false;
+    }
+
+    switch (type) {
+    case UserField::Integer:
+      if (!is.skip(sizeof(uint64_t))) {
+        return false;
+      }
+      break;
+
+    case UserField::String: {
+      internal::byte_view value;
+      if (!is.get_string_view(value)) {
+        return false;
+      }
+      break;
+    }
+
+    case UserField::Amount: {
+      ::csdb::Amount value;
+      if (!is.get(value)) {
+        return false;
+      }
+      break;
+    }
+
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace priv
+} // namespace csdb
+
+#endif // _CREDITS_CSDB_VIEW_PRIVATE_H_INCLUDED_
@@ -252,3 +252,39 @@ TEST_F(BinaryStreams, MapFilled)
   EXPECT_TRUE(i.empty());
   EXPECT_EQ(v1, v2);
 }
+
+TEST_F(BinaryStreams, Sink)
+{
+  struct Sink : ::csdb::internal::byte_sink
+  {
+    void write(const void* data, size_t size) override
+    {
+      const uint8_t* bytes = static_cast<const uint8_t*>(data);
+      buffer.insert(buffer.end(), bytes, bytes + size);
+      ++writes;
+    }
+
+    ::csdb::internal::byte_array buffer;
+    size_t writes = 0;
+  };
+
+  ::std::map<int, ::std::string> map;
+  map.emplace(1, "Key1");
+  map.emplace(2, "Key2");
+  Test t{10, true, "Test"};
+
+  obstream o;
+  o.put(map);
+  o.put(t);
+  o.put(from_string("Bytes"));
+
+  Sink sink;
+  obstream os(&sink);
+  os.put(map);
+  os.put(t);
+  os.put(from_string("Bytes"));
+
+  EXPECT_TRUE(os.buffer().empty());
+  EXPECT_EQ(sink.buffer, o.buffer());
+  EXPECT_GT(sink.writes, static_cast<size_t>(1));
+}
@@ -50,6 +50,14 @@ TEST_F(StorageTestNotOpen, LastError)
   EXPECT_FALSE(s.db_last_error_message().empty());
 }
 
+TEST_F(StorageTestNotOpen, CacheSize)
+{
+  ::csdb::Storage s;
+  EXPECT_EQ(s.cache_size(), 0u);
+  EXPECT_FALSE(s.set_cache_size(1 << 20));
+  EXPECT_EQ(s.last_error(), ::csdb::Storage::NotOpen);
+}
+
 TEST_F(StorageTestNotOpen, FailedOpen)
 {
   ::csdb::Storage s;
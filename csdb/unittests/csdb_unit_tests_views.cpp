@@ -0,0 +1,331 @@
+#include "csdb/transaction_view.h"
+#include "csdb/pool_view.h"
+#include "csdb/pool_reader.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "csdb_unit_tests_environment.h"
+
+#include "csdb/address.h"
+#include "csdb/currency.h"
+#include "csdb/pool.h"
+#include "csdb/transaction.h"
+
+class ViewsTest : public ::testing::Test
+{
+protected:
+  //Splits the data into small pages, as packets do
+  struct PagedSink : ::csdb::internal::byte_sink
+  {
+    static constexpr size_t page_size = 7;
+
+    void write(const void* data, size_t size) override
+    {
+      const uint8_t* bytes = static_cast<const uint8_t*>(data);
+      while (size > 0) {
+        if (pages.empty() || pages.back().size() == page_size) {
+          pages.emplace_back();
+        }
+
+        const size_t part = ::std::min(size, page_size - pages.back().size());
+        pages.back().insert(pages.back().end(), bytes, bytes + part);
+        bytes += part;
+        size -= part;
+      }
+    }
+
+    ::std::vector<char> join() const
+    {
+      ::std::vector<char> res;
+      for (const auto& page : pages) {
+        res.insert(res.end(), page.begin(), page.end());
+      }
+      return res;
+    }
+
+    ::std::vector<::std::vector<char>> pages;
+  };
+
+  ::csdb::Transaction make_transaction(int64_t innerID, const ::csdb::Address& source,
+                                       const ::csdb::Address& target)
+  {
+    ::csdb::Transaction t{innerID, source, target, ::csdb::Currency("CS"), ::csdb::Amount(innerID, 25),
+                          ::csdb::Amount(1), ::csdb::Amount(0, 5), "signature", ::csdb::Amount(100)};
+    t.add_user_field(1, 12345);
+    t.add_user_field(2, "Comment");
+    t.add_user_field(3, ::csdb::Amount(7, 50));
+    return t;
+  }
+
+  ::csdb::Address addr1 = ::csdb::Address::from_string("0000000000000000000000000000000000000000");
+  ::csdb::Address addr2 = ::csdb::Address::from_string("0000000000000000000000000000000000000001");
+  ::csdb::Address addr3 = ::csdb::Address::from_string("0000000000000000000000000000000000000002");
+};
+
+using namespace csdb;
+
+TEST_F(ViewsTest, TransactionFields)
+{
+  const Transaction t = make_transaction(42, addr1, addr2);
+  const auto bytes = t.to_byte_stream();
+
+  TransactionView view;
+  ASSERT_TRUE(view.parse(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+  EXPECT_TRUE(view.is_valid());
+  EXPECT_EQ(view.binary_size(), bytes.size());
+
+  EXPECT_EQ(view.innerID(), t.innerID());
+  EXPECT_EQ(view.source().to_array(), addr1.public_key());
+  EXPECT_EQ(view.target().to_array(), addr2.public_key());
+  EXPECT_EQ(::std::string(reinterpret_cast<const char*>(view.currency().data), view.currency().size), "CS");
+  EXPECT_EQ(view.amount(), t.amount());
+  EXPECT_EQ(view.max_fee(), t.max_fee());
+  EXPECT_EQ(view.counted_fee(), t.counted_fee());
+  EXPECT_EQ(view.user_fields_count(), static_cast<size_t>(3));
+  EXPECT_EQ(::std::string(reinterpret_cast<const char*>(view.signature().data), view.signature().size), t.signature());
+  EXPECT_EQ(view.balance(), t.balance());
+
+  const Transaction res = view.to_transaction();
+  EXPECT_EQ(res.to_byte_stream(), bytes);
+  EXPECT_EQ(res.user_field(2).value<::std::string>(), "Comment");
+}
+
+TEST_F(ViewsTest, TransactionSameAddresses)
+{
+  const auto bytes = make_transaction(1, addr1, addr1).to_byte_stream();
+
+  TransactionView view;
+  ASSERT_TRUE(view.parse(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+  EXPECT_FALSE(view.is_valid());
+}
+
+TEST_F(ViewsTest, TransactionTruncated)
+{
+  const auto bytes = make_transaction(1, addr1, addr2).to_byte_stream();
+
+  TransactionView view;
+  for (size_t size = 0; size < bytes.size(); ++size) {
+    EXPECT_FALSE(view.parse(reinterpret_cast<const char*>(bytes.data()), size)) << size;
+    EXPECT_FALSE(view.is_valid());
+    EXPECT_EQ(view.binary_size(), static_cast<size_t>(0));
+  }
+}
+
+TEST_F(ViewsTest, TransactionsSequence)
+{
+  ::std::vector<uint8_t> bytes;
+  for (int64_t i = 0; i < 3; ++i) {
+    const auto t = make_transaction(i, addr1, addr2).to_byte_stream();
+    bytes.insert(bytes.end(), t.begin(), t.end());
+  }
+
+  const char* pos = reinterpret_cast<const char*>(bytes.data());
+  const char* end = pos + bytes.size();
+
+  TransactionView view;
+  for (int64_t i = 0; i < 3; ++i) {
+    ASSERT_TRUE(view.parse(pos, end - pos));
+    EXPECT_EQ(view.innerID(), i);
+    pos += view.binary_size();
+  }
+
+  EXPECT_EQ(pos, end);
+}
+
+TEST_F(ViewsTest, Pool)
+{
+  Pool pool{PoolHash::calc_from_data({1, 2, 3}), 10};
+  ASSERT_TRUE(pool.add_transaction(make_transaction(1, addr1, addr2), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(2, addr2, addr3), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(3, addr3, addr1), true));
+  ASSERT_TRUE(pool.add_user_field(UFID_COMMENT, "Comment"));
+  pool.set_writer_public_key(addr1.public_key());
+
+  uint32_t size;
+  const char* data = pool.to_byte_stream(size);
+
+  PoolView view;
+  ASSERT_TRUE(view.parse(data, size));
+  EXPECT_EQ(view.binary_size(), static_cast<size_t>(size));
+  EXPECT_EQ(view.previous_hash().to_array(), pool.previous_hash().to_binary());
+  EXPECT_EQ(view.sequence(), pool.sequence());
+  EXPECT_EQ(view.user_fields_count(), static_cast<size_t>(1));
+  EXPECT_EQ(view.transactions_count(), static_cast<size_t>(3));
+  EXPECT_EQ(view.writer_public_key().to_array(), addr1.public_key());
+  EXPECT_EQ(view.signature().size, static_cast<size_t>(0));
+
+  size_t i = 0;
+  for (const auto& t : view) {
+    ASSERT_LT(i, pool.transactions_count());
+    EXPECT_TRUE(t.is_valid());
+    EXPECT_EQ(t.innerID(), pool.transaction(i).innerID());
+    ++i;
+  }
+  EXPECT_EQ(i, view.transactions_count());
+
+  const Pool res = view.to_pool();
+  EXPECT_TRUE(res.is_valid());
+  EXPECT_EQ(res.transactions_count(), pool.transactions_count());
+  EXPECT_EQ(res.hash(), PoolHash::calc_from_data(::csdb::internal::byte_array(data, data + size)));
+}
+
+TEST_F(ViewsTest, PoolEmpty)
+{
+  Pool pool{PoolHash(), 0};
+
+  uint32_t size;
+  const char* data = pool.to_byte_stream(size);
+
+  PoolView view;
+  ASSERT_TRUE(view.parse(data, size));
+  EXPECT_EQ(view.transactions_count(), static_cast<size_t>(0));
+  EXPECT_TRUE(view.begin() == view.end());
+}
+
+TEST_F(ViewsTest, PoolTruncated)
+{
+  Pool pool{PoolHash::calc_from_data({1, 2, 3}), 10};
+  ASSERT_TRUE(pool.add_transaction(make_transaction(1, addr1, addr2), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(2, addr2, addr3), true));
+
+  uint32_t size;
+  const char* data = pool.to_byte_stream(size);
+
+  PoolView view;
+  for (uint32_t part = 0; part < size; ++part) {
+    EXPECT_FALSE(view.parse(data, part)) << part;
+    EXPECT_EQ(view.transactions_count(), static_cast<size_t>(0));
+    EXPECT_TRUE(view.begin() == view.end());
+  }
+}
+
+TEST_F(ViewsTest, PoolBadTransactionsCount)
+{
+  Pool pool{PoolHash(), 0};
+  ASSERT_TRUE(pool.add_transaction(make_transaction(1, addr1, addr2), true));
+
+  uint32_t size;
+  char* data = pool.to_byte_stream(size);
+  ::std::vector<char> bytes(data, data + size);
+
+  //Previous hash, sequence and user fields go before the count
+  const size_t count_pos = sizeof(size_t) + sizeof(Pool::sequence_t) + sizeof(size_t);
+  const size_t count = 1000000;
+  memcpy(bytes.data() + count_pos, &count, sizeof(count));
+
+  PoolView view;
+  EXPECT_FALSE(view.parse(bytes.data(), bytes.size()));
+}
+
+TEST_F(ViewsTest, TransactionToSink)
+{
+  const Transaction t = make_transaction(7, addr1, addr2);
+  const auto bytes = t.to_byte_stream();
+
+  PagedSink sink;
+  t.to_byte_stream(sink);
+  EXPECT_GT(sink.pages.size(), static_cast<size_t>(1));
+
+  const auto joined = sink.join();
+  EXPECT_EQ(::std::vector<char>(bytes.begin(), bytes.end()), joined);
+
+  TransactionView view;
+  ASSERT_TRUE(view.parse(joined.data(), joined.size()));
+  EXPECT_EQ(view.innerID(), 7);
+}
+
+TEST_F(ViewsTest, PoolToSink)
+{
+  Pool pool{PoolHash::calc_from_data({1, 2, 3}), 10};
+  ASSERT_TRUE(pool.add_transaction(make_transaction(1, addr1, addr2), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(2, addr2, addr3), true));
+  pool.set_writer_public_key(addr1.public_key());
+
+  //Serialized without the cached representation
+  PagedSink sink;
+  pool.to_byte_stream(sink);
+  const auto joined = sink.join();
+
+  uint32_t size;
+  const char* data = pool.to_byte_stream(size);
+  EXPECT_EQ(::std::vector<char>(data, data + size), joined);
+
+  //And with it
+  PagedSink cached;
+  pool.to_byte_stream(cached);
+  EXPECT_EQ(cached.join(), joined);
+
+  PoolView view;
+  ASSERT_TRUE(view.parse(joined.data(), joined.size()));
+  EXPECT_EQ(view.transactions_count(), static_cast<size_t>(2));
+}
+
+TEST_F(ViewsTest, PoolReaderByPages)
+{
+  Pool pool{PoolHash::calc_from_data({1, 2, 3}), 10};
+  ASSERT_TRUE(pool.add_transaction(make_transaction(1, addr1, addr2), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(2, addr2, addr3), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(3, addr3, addr1), true));
+  ASSERT_TRUE(pool.add_user_field(UFID_COMMENT, "Comment"));
+  pool.set_writer_public_key(addr1.public_key());
+
+  PagedSink sink;
+  pool.to_byte_stream(sink);
+  const auto bytes = sink.join();
+
+  PoolReader reader;
+  size_t read = 0;
+  for (const auto& page : sink.pages) {
+    reader.feed(page.data(), page.size());
+    EXPECT_GE(reader.transactions_read(), read);
+    read = reader.transactions_read();
+  }
+
+  //Everything but the tail is read before the end
+  EXPECT_TRUE(reader.is_header_read());
+  EXPECT_EQ(reader.transactions_count(), static_cast<size_t>(3));
+  EXPECT_EQ(reader.transactions_read(), static_cast<size_t>(3));
+
+  Pool res;
+  ASSERT_TRUE(reader.finish(res));
+  EXPECT_EQ(reader.bytes_fed(), static_cast<size_t>(0));
+
+  const Pool expected = Pool::from_byte_stream(bytes.data(), bytes.size());
+  EXPECT_EQ(res.hash(), expected.hash());
+  EXPECT_EQ(res.sequence(), pool.sequence());
+  EXPECT_EQ(res.writer_public_key(), pool.writer_public_key());
+  EXPECT_EQ(res.user_field(UFID_COMMENT).value<::std::string>(), "Comment");
+  ASSERT_EQ(res.transactions_count(), pool.transactions_count());
+  for (size_t i = 0; i < res.transactions_count(); ++i) {
+    EXPECT_EQ(res.transaction(i).to_byte_stream(), pool.transaction(i).to_byte_stream());
+  }
+}
+
+TEST_F(ViewsTest, PoolReaderIncomplete)
+{
+  Pool pool{PoolHash::calc_from_data({1, 2, 3}), 10};
+  ASSERT_TRUE(pool.add_transaction(make_transaction(1, addr1, addr2), true));
+  ASSERT_TRUE(pool.add_transaction(make_transaction(2, addr2, addr3), true));
+
+  uint32_t size;
+  const char* data = pool.to_byte_stream(size);
+
+  for (uint32_t part = 0; part < size; ++part) {
+    PoolReader reader;
+    reader.feed(data, part);
+
+    Pool res;
+    EXPECT_FALSE(reader.finish(res)) << part;
+  }
+
+  //Extra bytes after the pool
+  PoolReader reader;
+  reader.feed(data, size);
+  reader.feed(data, 1);
+
+  Pool res;
+  EXPECT_FALSE(reader.finish(res));
+}
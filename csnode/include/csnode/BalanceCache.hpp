@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/address.h>
+#include <csdb/amount.h>
+#include <csdb/pool.h>
+
+#include "BoundedQueue.hpp"
+#include "Pipeline.hpp"
+#include "Snapshot.hpp"
+
+namespace Credits {
+
+/* The balances of the addresses, split by address into shards locked on their own.
+   Every shard knows the last block applied to it, and a balance that was current
+   then is followed: it stays current as the blocks go, and only the blocks touching
+   its address update it. The rest are as of their own block, left to be walked from
+   there. Every block written is applied: the effects of its transactions are grouped
+   by the shard of the address they touch, and the shards are applied by a pool of
+   threads together with the caller. Within a shard the effects go in the order of
+   the transactions, so the balances are the same whatever the number of threads,
+   and the same as walking the chain back. Configured by the optional [apply]
+   section:
+
+     threads=2           ; Helpers besides the calling thread
+     shards=64 */
+class BalanceCache {
+public:
+	struct Balance {
+		csdb::PoolHash hash;  // The block it is the balance after
+		csdb::Amount amount;
+	};
+
+	BalanceCache();
+	~BalanceCache();
+
+	// Before anything is put, with the last block of the chain. The blocks are
+	// applied by the caller alone until started
+	void load(const boost::property_tree::ptree& config, const csdb::PoolHash& tip);
+	void start(std::function<void()> onWorkerStart = nullptr);
+
+	// A followed balance is given as of the last block applied to its shard
+	bool get(const csdb::Address&, Balance&) const;
+	void put(const csdb::Address&, const Balance&);
+
+	// Goes through the addresses of the block only
+	void apply(csdb::Pool&);
+
+	size_t size() const;
+
+	// Drops the entries beyond the count, in the address order of every shard
+	void shrink(size_t count);
+
+	void write(SnapshotWriter&) const;
+	bool read(SnapshotReader&);
+
+	void report(std::ostream&) const;
+
+private:
+	struct Entry {
+		Balance balance;  // The hash is the last block it was known at
+		bool followed;    // Current as of the tip of the shard
+	};
+
+	struct Shard {
+		std::map<csdb::Address, Entry> balances;
+		csdb::PoolHash tip;  // The last block applied
+		mutable std::mutex lock;
+	};
+
+	struct Effect {
+		const csdb::Transaction* transaction;
+		bool source;
+	};
+
+	struct Job {
+		const csdb::Pool* pool;
+		const std::vector<std::vector<Effect>>* effects;
+
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> inFlight{ 0 };
+	};
+
+	typedef std::shared_ptr<Job> JobPtr;
+
+	Shard& getShard(const csdb::Address&) const;
+
+	void work(Job&);
+	void applyShard(Shard&, const csdb::Pool&, const std::vector<Effect>&);
+	void workerRoutine(std::function<void()> onStart);
+
+	std::unique_ptr<Shard[]> shards_;
+	size_t shardsCount_;
+	size_t threads_;
+
+	std::unique_ptr<BoundedQueue<JobPtr>> jobs_;
+
+	StageStats stats_;
+	std::atomic<uint64_t> blocks_{ 0 };
+
+	std::atomic_bool quit_{ false };
+	std::vector<std::thread> workers_;
+};
+
+} // namespace Credits
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/pool.h>
+#include <csdb/pool_reader.h>
+#include <net/Hash.hpp>
+
+#include "Pipeline.hpp"
+
+namespace Credits {
+
+/* Blocks read while their fragments arrive. The network thread passes every fragment
+   continuing the in-order prefix received so far, a stage of its own builds the
+   transactions from them, and the decode worker of the complete message takes the
+   pool with only its tail left to read. Configured by the optional [assembly] section:
+
+     enabled=true
+     maxBlocks=4         ; Assembled at once, the oldest one is dropped */
+class BlockAssembler {
+public:
+	BlockAssembler();
+
+	void load(const boost::property_tree::ptree& config);
+
+	bool isEnabled() const { return enabled_; }
+
+	// Network thread, the fragments of a message in order
+	void addFragment(const Hash& key, size_t index, size_t count, const char* data, size_t size);
+
+	// Decode workers. False if the block has not been assembled, it is read whole then
+	bool take(const Hash& key, csdb::Pool&);
+
+	std::thread::native_handle_type getThreadHandle() { return stage_.getThreadHandle(); }
+
+	void report(std::ostream&) const;
+
+private:
+	struct Block {
+		Hash key;
+		size_t count;
+
+		std::atomic<size_t> pushed{ 0 };  // Fragments passed to the stage
+		std::atomic<size_t> fed{ 0 };     // and read by it
+		csdb::PoolReader reader;
+	};
+
+	typedef std::shared_ptr<Block> BlockPtr;
+
+	bool enabled_ = true;
+	size_t maxBlocks_;
+
+	std::mutex mutex_;
+	std::deque<BlockPtr> blocks_;
+
+	std::atomic<uint64_t> assembled_{ 0 };
+	std::atomic<uint64_t> missed_{ 0 };
+
+	SerialStage stage_;
+};
+
+} // namespace Credits
@@ -1,21 +1,34 @@
 #pragma once
 
+#include <deque>
 #include <map>
 #include <mutex>
 
+#include <boost/property_tree/ptree.hpp>
+
 #include <csdb/address.h>
 #include <csdb/amount.h>
 #include <csdb/pool.h>
 #include <csdb/storage.h>
 
+#include "BalanceCache.hpp"
+#include "MemoryBudget.hpp"
+#include "Pipeline.hpp"
+#include "Snapshot.hpp"
+
 namespace Credits {
 
 class BlockChain {
 public:
-	BlockChain(const char* path);
+	// Also loads the snapshot, for the caches created after the chain
+	BlockChain(const char* path, const boost::property_tree::ptree& config);
 
+	// Takes the pool. Composed on the calling thread, the getters and the loads below
+	// see it right away, and saved by the storage stage. Waits when the stage is too
+	// far behind
 	void writeLastBlock(csdb::Pool&& pool);
 
+	// With the blocks still queued for the storage
 	csdb::PoolHash getLastHash();
 	size_t getSize();
 
@@ -27,15 +40,44 @@ public:
 
 	bool isGood() const { return good_; }
 
+	std::thread::native_handle_type getStorageThread() const { return storage_.write_thread_handle(); }
+	SerialStage& getStorageStage() { return storageStage_; }
+
+	Snapshot& getSnapshot() { return snapshot_; }
+
+	// For the caches of the node, the ones of the chain already added
+	MemoryBudget& getMemoryBudget() { return memoryBudget_; }
+
+	// Every block written is applied to it on the storage stage
+	BalanceCache& getBalanceCache() { return balances_; }
+
+	// Captures the parts on the calling thread, and writes them on the storage
+	// stage tagged with the last block written before
+	void saveSnapshot();
+
 	static csdb::Address getAddressFromKey(const char*);
 
 private:
+	void save(csdb::Pool& pool);
+	bool findQueued(const csdb::PoolHash&, csdb::Pool&);
+
 	bool good_ = false;
 
-	std::map<csdb::Address, std::pair<csdb::PoolHash, csdb::Amount>> balancesCache_;
+	BalanceCache balances_;
 
 	std::mutex dbLock_;
 	csdb::Storage storage_;
+
+	// Set by the writer on every block composed
+	std::mutex tipLock_;
+	csdb::PoolHash tipHash_;
+	size_t tipSize_ = 0;
+	std::deque<csdb::Pool> queued_;  // Composed, not saved yet
+
+	SerialStage storageStage_;
+
+	Snapshot snapshot_;
+	MemoryBudget memoryBudget_;
 };
 
 } // namespace Credits
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace Credits {
+
+const size_t CACHE_LINE_SIZE = 64;
+
+/* Lock-free multi-producer multi-consumer queue of a fixed capacity, rounded up to
+   a power of two. Every cell carries a sequence number telling whether it is free
+   for the producer or ready for the consumer of the current lap */
+template <typename T>
+class BoundedQueue {
+public:
+	explicit BoundedQueue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+
+		mask_ = size - 1;
+		cells_.reset(new Cell[size]);
+		for (size_t i = 0; i < size; ++i)
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	bool tryPush(T&& value) {
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		for (;;) {
+			cell = &cells_[pos & mask_];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+			if (diff == 0) {
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;  // Full
+			else
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+		}
+
+		cell->data = std::move(value);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T& value) {
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		for (;;) {
+			cell = &cells_[pos & mask_];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+			if (diff == 0) {
+				if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;  // Empty
+			else
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+		}
+
+		value = std::move(cell->data);
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Approximate when used concurrently
+	size_t size() const {
+		const size_t enq = enqueuePos_.load(std::memory_order_relaxed);
+		const size_t deq = dequeuePos_.load(std::memory_order_relaxed);
+		return enq > deq ? enq - deq : 0;
+	}
+
+	size_t capacity() const { return mask_ + 1; }
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	typedef std::atomic<size_t> Position;
+
+	// The positions are on cache lines of their own, padded rather than over-aligned
+	// for the queues to be allocated by the plain new of C++14
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_;
+
+	char padBeforeEnqueue_[CACHE_LINE_SIZE];
+	Position enqueuePos_{ 0 };
+	char padBeforeDequeue_[CACHE_LINE_SIZE - sizeof(Position)];
+	Position dequeuePos_{ 0 };
+	char padAfterDequeue_[CACHE_LINE_SIZE - sizeof(Position)];
+};
+
+// Waiting of the idle stage threads: spin a little, then sleep
+class Backoff {
+public:
+	void wait() {
+		if (spins_ < 64) {
+			++spins_;
+			std::this_thread::yield();
+		}
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	void reset() { spins_ = 0; }
+
+private:
+	unsigned spins_ = 0;
+};
+
+} // namespace Credits
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <cscrypto/cscrypto.h>
+#include <csdb/pool.h>
+#include <csdb/transaction.h>
+
+namespace Credits {
+
+typedef cscrypto::Hash TransactionDigest;
+
+// Salted SipHash of the digest, only the lower SHORT_ID_BYTES go to the wire
+typedef uint64_t ShortTransactionId;
+typedef std::array<uint8_t, 16> ShortIdKey;
+
+const size_t SHORT_ID_BYTES = 6;
+
+TransactionDigest getDigest(const csdb::Transaction&);
+
+/* Block candidate sent as the short ids of its transactions. The key of the ids
+   is made of a random salt and the checksum, so a collision in one candidate is
+   not repeated in the next one */
+struct CompactCandidate {
+	uint64_t salt = 0;
+	TransactionDigest checksum;  // Over the digests of all the transactions, in order
+	std::vector<ShortTransactionId> ids;
+	csdb::Pool header;           // The candidate without its transactions
+
+	ShortIdKey getKey() const;
+};
+
+/* A candidate being rebuilt: the transactions found locally are in place, the
+   rest is fetched from the main node */
+struct PartialCandidate {
+	CompactCandidate compact;
+	std::vector<csdb::Transaction> transactions;  // Invalid where missing
+	std::vector<TransactionDigest> digests;       // Of the transactions in place
+	std::vector<uint32_t> missing;
+
+	// Puts the fetched transactions, given in the order of `missing`
+	bool fill(std::vector<csdb::Transaction>&&);
+
+	// Fails if the checksum does not match, i.e. a short id matched a wrong transaction
+	bool build(csdb::Pool&) const;
+
+	// After a failed build
+	void missAll();
+};
+
+/* Compact relay of the block candidates. Every confidant keeps the transactions it
+   has recently received, and the main node sends a candidate as short ids of its
+   transactions; a confidant asks the main node only for the ones it has not seen.
+   Configured by the optional [compact] section:
+
+     enabled=false       ; Also sends the outgoing transactions to the confidants
+     keep=65536          ; Recently received transactions kept by a node
+     sentKept=8          ; Candidates the main node answers the requests for */
+class CompactRelay {
+public:
+	CompactRelay();
+
+	void load(const boost::property_tree::ptree& config);
+
+	bool isEnabled() const { return enabled_; }
+
+	// Thread-safe, called by the decode workers
+	void addSeen(const std::vector<csdb::Transaction>&);
+	PartialCandidate rebuild(CompactCandidate&&) const;
+
+	/* Main node */
+	CompactCandidate makeCandidate(const csdb::Pool&);
+
+	// False if the candidate is not kept any more or an index is out of range
+	bool getTransactions(uint64_t salt, const std::vector<uint32_t>& indices, std::vector<csdb::Transaction>&) const;
+
+	/* Confidants, the candidate waiting for its missing transactions */
+	void setPending(PartialCandidate&&);
+	bool isPending(uint64_t salt) const { return hasPending_ && pending_.compact.salt == salt; }
+	PartialCandidate& getPending() { return pending_; }
+	void dropPending();
+
+	void onRoundStart();
+
+	void report(std::ostream&) const;
+
+private:
+	struct Seen {
+		TransactionDigest digest;
+		csdb::Transaction transaction;
+	};
+
+	struct Sent {
+		uint64_t salt;
+		csdb::Pool pool;
+	};
+
+	bool enabled_ = false;
+	size_t keep_;
+	size_t sentKept_;
+
+	mutable std::mutex mutex_;
+	std::deque<Seen> seen_;
+
+	std::deque<Sent> sent_;
+
+	PartialCandidate pending_;
+	bool hasPending_ = false;
+
+	mutable std::atomic<uint64_t> candidates_{ 0 };
+	mutable std::atomic<uint64_t> found_{ 0 };
+	mutable std::atomic<uint64_t> missed_{ 0 };
+	uint64_t requests_ = 0;
+};
+
+} // namespace Credits
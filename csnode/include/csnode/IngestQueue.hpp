@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <ostream>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/transaction.h>
+
+#include "BoundedQueue.hpp"
+
+namespace Credits {
+
+/* Wallet transactions from the API threads, handed to the solver by the node thread.
+   The API threads push without locking each other, and the node thread takes a batch
+   at every tick. A pushed transaction is acknowledged once the solver has it.
+   Configured by the optional [ingest] section:
+
+     queueSize=4096
+     batch=256           ; Taken by the node at a tick at most
+     timeout=5           ; Seconds an API thread waits for the acknowledgement */
+class IngestQueue {
+public:
+	typedef std::function<void(csdb::Transaction&&)> Consumer;
+
+	// Built with the config at once, the API may push before the node is initialized
+	explicit IngestQueue(const boost::property_tree::ptree& config);
+
+	// Any thread. False at once if the queue is full
+	std::future<bool> push(csdb::Transaction);
+
+	// Any thread. Waits for the acknowledgement, a transaction timed out may still be taken
+	bool submit(csdb::Transaction);
+
+	// On the node thread, returns the number taken
+	size_t drain(const Consumer&);
+
+	void report(std::ostream&) const;
+
+private:
+	struct Request {
+		csdb::Transaction transaction;
+		std::promise<bool> taken;
+	};
+
+	BoundedQueue<Request> queue_;
+	size_t batch_;
+	std::chrono::seconds timeout_;
+
+	std::atomic<uint64_t> pushed_{ 0 };
+	std::atomic<uint64_t> full_{ 0 };
+	std::atomic<uint64_t> timedOut_{ 0 };
+	uint64_t taken_ = 0;
+	uint64_t ticks_ = 0;  // With anything taken
+};
+
+} // namespace Credits
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/address.h>
+#include <csdb/pool.h>
+#include <csdb/transaction.h>
+
+#include <cscrypto/cscrypto.h>
+
+#include "BoundedQueue.hpp"
+#include "Pipeline.hpp"
+
+namespace Credits {
+
+/* Synthetic load for the capacity tests: signed transfers between generated wallets,
+   sent by the node as if its clients did. A thread of its own signs them ahead, they
+   are sent at the configured rate whatever the network keeps up with, and the time
+   from the sending to the block with them is reported as percentiles. Configured by
+   the optional [load] section:
+
+     enabled=false
+     wallets=100
+     rate=100            ; Transactions per second
+     presigned=10000     ; Signed ahead of the sending at most
+     timeout=60          ; Seconds until a transaction not in a block is counted lost */
+class LoadGenerator {
+public:
+	typedef std::function<void(const csdb::Transaction&)> Sender;
+
+	LoadGenerator() = default;
+	~LoadGenerator();
+
+	void start(const boost::property_tree::ptree& config, Sender, std::function<void()> onSignerStart = nullptr);
+
+	bool isEnabled() const { return enabled_; }
+
+	// On the node thread, like the ones below. Sends the transactions due by now
+	void poll();
+
+	// Every block the node gets or writes, the generated transactions in it are done
+	void onBlock(const csdb::Pool&);
+
+	// The percentiles are of the transactions done since the last report
+	void report(std::ostream&);
+
+private:
+	struct Wallet {
+		cscrypto::KeyPair keys;
+		csdb::Address address;
+		int64_t innerID = 0;  // Taken by the signer
+	};
+
+	typedef std::pair<std::string, int64_t> Key;  // Source and inner id
+
+	void signerRoutine(std::function<void()> onStart);
+	void expire(StageClock::time_point now);
+
+	bool enabled_ = false;
+	double rate_ = 0;
+	StageClock::duration timeout_;
+
+	std::vector<Wallet> wallets_;
+	std::unique_ptr<BoundedQueue<csdb::Transaction>> signed_;
+
+	Sender sender_;
+	StageClock::time_point started_;
+	uint64_t scheduled_ = 0;
+
+	std::map<Key, StageClock::time_point> pending_;
+	std::deque<std::pair<Key, StageClock::time_point>> sendOrder_;
+	std::vector<uint32_t> latenciesMs_;
+
+	uint64_t sent_ = 0;
+	uint64_t done_ = 0;
+	uint64_t starved_ = 0;  // Due when none was signed yet
+	uint64_t lost_ = 0;
+
+	std::atomic_bool quit_{ false };
+	std::thread signer_;
+};
+
+} // namespace Credits
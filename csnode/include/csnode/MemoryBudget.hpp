@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace Credits {
+
+/* Accounting of the memory the caches of the node take. Every cache adds its
+   usage and, if it can drop some of its entries, a way to shrink. Whenever the
+   total is over the budget, the caches of the lowest priority are shrunk first,
+   down to the target share of the budget. Configured by the optional [memory]
+   section:
+
+     budget=0            ; Bytes for all the caches, 0 for no limit
+     target=80           ; Percent of the budget to shrink down to */
+class MemoryBudget {
+public:
+	enum Priority {
+		Low,     // Rebuilt from the storage at once
+		Normal,  // Rebuilt by walking the chain
+		High     // Slows down the storage
+	};
+
+	typedef std::function<size_t()> Usage;
+
+	// Drops entries until the usage is at most the given bytes, as far as it can
+	typedef std::function<void(size_t)> Shrink;
+
+	MemoryBudget();
+
+	void load(const boost::property_tree::ptree& config);
+
+	size_t getBudget() const { return budget_; }
+
+	// Without shrink the part is only accounted, it takes from the budget of the others
+	void addPart(const std::string& name, Priority, Usage, Shrink = nullptr);
+	void removePart(const std::string& name);
+
+	// Shrinks the parts if they are over the budget, any thread
+	void enforce();
+
+	void report(std::ostream&) const;
+
+private:
+	struct Part {
+		std::string name;
+		Priority priority;
+		Usage usage;
+		Shrink shrink;
+	};
+
+	size_t budget_ = 0;
+	uint32_t target_;
+
+	mutable std::mutex lock_;
+	std::vector<Part> parts_;  // By priority
+
+	size_t shrinks_ = 0;
+	size_t freed_ = 0;
+};
+
+} // namespace Credits
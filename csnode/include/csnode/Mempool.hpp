@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/pool.h>
+#include <csdb/transaction.h>
+
+namespace Credits {
+
+/* Transactions waiting to get into a block, on the network thread only.
+
+   They are indexed by the source and its innerID, so a repeated transaction is
+   dropped; ordered by the fee and the arrival, so a candidate takes the best ones
+   without sorting; and chained per source by innerID, so the transactions of one
+   source are taken in order. The pool is bounded by memory, the cheapest ones are
+   evicted first, and the ones not taken for too long expire. Configured by the
+   optional [mempool] section:
+
+     maxBytes=67108864
+     maxRounds=10        ; Rounds a transaction is kept for, 0 to keep it until evicted */
+class Mempool {
+public:
+	enum Result {
+		Added,
+		Duplicate,
+		Underpriced,  // Full, and the transaction is the cheapest one
+		Invalid
+	};
+
+	Mempool();
+
+	void load(const boost::property_tree::ptree& config);
+
+	Result add(const csdb::Transaction&);
+
+	// The transactions of a block, or any others got by other means
+	void remove(const csdb::Transaction&);
+	void remove(csdb::Pool&);
+
+	// The best transactions for a candidate, taken out of the pool. The fees go down
+	// and every source's transactions are in the order of their innerIDs
+	std::vector<csdb::Transaction> take(size_t maxCount, size_t maxBytes);
+
+	void onRoundStart(uint32_t round);
+
+	size_t size() const { return entries_.size(); }
+	size_t bytes() const { return bytes_; }
+
+	void report(std::ostream&) const;
+
+private:
+	struct Key {
+		std::string source;
+		int64_t innerID;
+
+		bool operator==(const Key& other) const { return innerID == other.innerID && source == other.source; }
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& key) const { return std::hash<std::string>()(key.source) ^ std::hash<int64_t>()(key.innerID); }
+	};
+
+	struct Entry {
+		csdb::Transaction transaction;
+		const Key* key;
+		csdb::Amount fee;
+		uint64_t arrival;
+		uint32_t round;
+		size_t bytes;
+	};
+
+	// Higher fees first, then the earlier ones
+	struct ByFee {
+		bool operator()(const Entry* lhs, const Entry* rhs) const {
+			if (lhs->fee != rhs->fee) return lhs->fee > rhs->fee;
+			return lhs->arrival < rhs->arrival;
+		}
+	};
+
+	typedef std::map<int64_t, Entry*> Chain;  // By innerID
+
+	static Key getKey(const csdb::Transaction&);
+
+	void erase(Entry*);
+
+	size_t maxBytes_;
+	uint32_t maxRounds_;
+
+	std::unordered_map<Key, Entry, KeyHash> entries_;
+	std::set<Entry*, ByFee> byFee_;
+	std::unordered_map<std::string, Chain> chains_;
+	std::set<Entry*, ByFee> heads_;  // The first of every chain
+
+	size_t bytes_ = 0;
+	uint64_t arrivals_ = 0;
+	uint32_t round_ = 0;
+
+	uint64_t added_ = 0;
+	uint64_t duplicates_ = 0;
+	uint64_t evicted_ = 0;
+	uint64_t expired_ = 0;
+	uint64_t taken_ = 0;
+};
+
+} // namespace Credits
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <boost/asio.hpp>
 
@@ -12,7 +13,17 @@
 
 using namespace boost::asio;
 
+#include "BlockAssembler.hpp"
+#include "CompactRelay.hpp"
+#include "IngestQueue.hpp"
+#include "LoadGenerator.hpp"
+#include "Mempool.hpp"
 #include "Packstream.hpp"
+#include "Pipeline.hpp"
+#include "RoundTimeline.hpp"
+#include "SignatureVerifier.hpp"
+#include "Startup.hpp"
+#include "TransactionCoalescer.hpp"
 
 namespace Credits {
 
@@ -33,14 +44,24 @@ public:
 	void getTransaction(const char*, const size_t);
 	void getFirstTransaction(const char*, const size_t);
 	void getTransactionsList(const char*, const size_t);
+	void getCompactTransactionsList(const char*, const size_t, const NodeId&);
+	void getCandidateRequest(const char*, const size_t, const NodeId&);
+	void getCandidateTransactions(const char*, const size_t);
 	void getVector(const char*, const size_t, const NodeId&);
 	void getMatrix(const char*, const size_t, const NodeId&);
-	void getBlock(const char*, const size_t, const NodeId&);
+	void getBlock(const char*, const size_t, const NodeId&, const Hash& key);
+	void getBlockFragment(const Hash& key, size_t index, size_t count, const char*, const size_t);
 	void getHash(const char*, const size_t, const NodeId&);
 
+	// Applies the decoded messages and sends the delayed ones, on the network thread
+	void processPipeline();
+
+	// False if the pipeline holds back too much, the message is to be dropped
+	bool admitMessage() { return pipeline_.admit(); }
+
 	/* Outcoming requests forming */
 	void sendRoundTable();
-	void sendTransaction(const csdb::Transaction&);
+	void sendTransaction(const csdb::Transaction&);  // Coalesced
 	void sendTransaction(std::vector<csdb::Transaction>&&);
 	void sendFirstTransaction(const csdb::Transaction&);
 	void sendTransactionList(const csdb::Pool&, const NodeId&);
@@ -65,12 +86,32 @@ public:
 	NodeLevel getMyLevel() const { return myLevel_; }
 	const std::vector<NodeId>& getConfidants() const { return confidantNodes_; }
 
+	const RoundTimeline& getTimeline() const { return timeline_; }
+	const Startup& getStartup() const { return startup_; }
+
+	// The transactions the main node builds its candidates from
+	Mempool& getMempool() { return mempool_; }
+
 	BlockChain& getBlockChain() { return bc_; }
 	const BlockChain& getBlockChain() const { return bc_; }
 
 private:
 	bool init();
 
+	void processInitRing(const char*, const size_t);
+	void processRoundTable(const char*, const size_t);
+	void processVector(const char*, const size_t, const NodeId&);
+	void processMatrix(const char*, const size_t, const NodeId&);
+	void processHash(const char*, const size_t, const NodeId&);
+	void processCandidateRequest(const char*, const size_t, const NodeId&);
+
+	void gotCandidate(csdb::Pool&&);
+	void requestCandidateTransactions(const NodeId&);
+
+	// Called by the decode workers, log and reject the bad signatures
+	bool verifyTransactions(const std::vector<csdb::Transaction>&);
+	bool verifyBlock(csdb::Pool&);
+
 	inline bool readRoundData(bool);
 	void onRoundStart();
 
@@ -84,7 +125,7 @@ private:
 
 	// Current round state
 	uint32_t roundNum_ = 0;
-	NodeLevel myLevel_;
+	std::atomic<NodeLevel> myLevel_{ NodeLevel::Normal };  // Decode workers read it as a hint
 	NodeId mainNode_;
 
 	std::vector<NodeId> confidantNodes_;
@@ -98,11 +139,25 @@ private:
 
 	SessionIO* net_;
 	std::unique_ptr<ISolver> solver_;
-	
+
+	IngestQueue ingest_;  // Before the API, which pushes into it as soon as it serves
     csconnector::csconnector api;
 
+	Startup startup_;  // Its warm-ups use the above
+
 	IPackStream istream_;
 	OPackStream ostream_;
+
+	TransactionCoalescer coalescer_;
+	RoundTimeline timeline_;
+	SignatureVerifier verifier_;
+	CompactRelay relay_;
+	BlockAssembler assembler_;
+	Mempool mempool_;
+	LoadGenerator load_;
+
+	// Goes first on destruction, its workers call into the members above
+	Pipeline pipeline_;
 };
 
 } // namespace Credits
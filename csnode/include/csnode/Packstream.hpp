@@ -1,9 +1,15 @@
 #pragma once
 
+#include <functional>
+
 #include <csdb/pool.h>
+#include <csdb/pool_view.h>
 #include <csdb/transaction.h>
+#include <csdb/transaction_view.h>
 #include <Solver/ISolver.hpp>
 
+#include <net/SessionIO.hpp>
+
 class IPackStream {
 public:
 	void init(const char* ptr, const size_t size) {
@@ -14,7 +20,7 @@ public:
 
 	template <typename T>
 	IPackStream& operator>>(T& cont) {
-		if ((ptr_ - end_) < sizeof(cont)) good_ = false;
+		if ((size_t)(end_ - ptr_) < sizeof(cont)) good_ = false;
 		else {
 			cont = *(T*)ptr_;
 			ptr_ += sizeof(T);
@@ -45,9 +51,14 @@ private:
 	bool good_ = false;
 };
 
-class OPackStream {
+// Also the sink the csdb objects are serialized into, right into the packets
+class OPackStream : private csdb::internal::byte_sink {
 public:
-	OPackStream(SessionIO* net) : net_(net) { }
+	OPackStream(SessionIO* net) : getPacket_([net]() { return net->getEmptyPacket(); }) { }
+
+	// Standalone use, e.g. in benchmarks
+	template <size_t PageSize>
+	OPackStream(PacketManager<PageSize>* pacman) : getPacket_([pacman]() { return pacman->getFreePack(); }) { }
 
 	void init() {
 		parts_.clear();
@@ -84,8 +95,12 @@ public:
 	size_t lastSize() const { return ptr_ - parts_.back()->data; }
 
 private:
+	void write(const void* data, size_t size) override {
+		insertBytes((const char*)data, size);
+	}
+
 	void newPack() {
-		parts_.emplace_back(net_->getEmptyPacket());
+		parts_.emplace_back(getPacket_());
 		ptr_ = parts_.back()->data;
 		end_ = ptr_ + sizeof(Packet::data);
 	}
@@ -106,7 +121,7 @@ private:
 	char* end_;
 	std::vector<PacketPtr> parts_;
 
-	SessionIO* net_;
+	std::function<PacketPtr()> getPacket_;
 };
 
 template <>
@@ -121,6 +136,13 @@ IPackStream& IPackStream::operator>>(csdb::Transaction& cont);
 template <>
 IPackStream& IPackStream::operator>>(csdb::Pool& pool);
 
+// Views into the stream bytes, they take only as much as the object needs
+template <>
+IPackStream& IPackStream::operator>>(csdb::TransactionView& view);
+
+template <>
+IPackStream& IPackStream::operator>>(csdb::PoolView& view);
+
 template <>
 OPackStream& OPackStream::operator<<(const Credits::NodeId& d);
 
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace Credits {
+
+enum class PerfStage {
+	Receive,     // Network thread, a datagram from the socket to the pipeline
+	Reassemble,  // Fragments collected and combined, within the receive
+	Decode,      // Pipeline workers
+	Verify,      // Signatures, within the decode mostly
+	Solver,      // Pipeline apply on the node thread
+	Storage,     // Blocks written
+	Api,         // A Thrift call
+	Count
+};
+
+/* Hardware counters of the threads, attributed to the stages they run. Every thread
+   opens its own counters (perf_event_open, user space only) on its first counted
+   section; a section adds what the counters went by to its stage. The stages include
+   the sections nested in them. The ratios since the last report go to the metrics
+   line, telling a memory-bound stage (cache misses) from a compute-bound one (IPC).
+   Linux only, off where the counters can't be opened. Configured by the optional
+   [perf] section:
+
+     enabled=false
+     sample=16           ; One in this many sections of a thread is counted */
+class PerfCounters {
+public:
+	enum Counter {
+		Cycles,
+		Instructions,
+		CacheMisses,
+		BranchMisses,
+		CounterCount
+	};
+
+	// Process-wide, before the counted threads start. False if they can't be counted
+	static bool load(const boost::property_tree::ptree& config);
+
+	static bool isEnabled();
+
+	// And starts the next interval
+	static void report(std::ostream&);
+
+	static const char* getStageName(PerfStage);
+};
+
+// Counts the section till the end of the scope, on the thread that made it
+class PerfScope {
+public:
+	explicit PerfScope(PerfStage stage);
+	~PerfScope();
+
+	PerfScope(const PerfScope&) = delete;
+	PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+	PerfStage stage_;
+	bool counted_ = false;
+	uint64_t started_[PerfCounters::CounterCount];
+};
+
+} // namespace Credits
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "BoundedQueue.hpp"
+
+namespace Credits {
+
+typedef std::chrono::steady_clock StageClock;
+
+struct StageStats {
+	std::atomic<uint64_t> processed{ 0 };
+	std::atomic<uint64_t> overflowed{ 0 };  // Queue full, held back in order until it has room
+	std::atomic<uint64_t> dropped{ 0 };     // Held back ones at their limit, not taken
+	std::atomic<uint64_t> stalls{ 0 };      // Held back ones at their limit, the producer waited
+	std::atomic<uint64_t> waitUs{ 0 };      // In the queue
+	std::atomic<uint64_t> workUs{ 0 };      // In the stage itself
+	std::atomic<size_t> maxDepth{ 0 };
+
+	void add(StageClock::time_point queued, StageClock::time_point started, StageClock::time_point finished);
+	void updateDepth(size_t depth);
+
+	void report(std::ostream&, const char* name, size_t depth) const;
+};
+
+/* Single thread executing actions in order, fed by a bounded queue. When the queue
+   is full, the action goes to an overflow list, and so do the ones after it till the
+   stage has taken the list in. The list is bounded as well: at its limit push waits
+   for the stage, and tryPush refuses the action */
+class SerialStage {
+public:
+	typedef std::function<void()> Action;
+
+	// The overflow limit is the capacity when not given
+	explicit SerialStage(size_t capacity, size_t overflowLimit = 0);
+	~SerialStage();
+
+	void push(Action);
+
+	// For the producers that can do without the action rather than wait
+	bool tryPush(Action);
+
+	// Waits for everything pushed so far to be done
+	void drain();
+
+	size_t depth() const { return pushed_.load() - done_.load(); }
+	const StageStats& getStats() const { return stats_; }
+
+	std::thread::native_handle_type getThreadHandle() { return thread_.native_handle(); }
+
+private:
+	struct Job {
+		Action action;
+		StageClock::time_point queued;
+	};
+
+	void run();
+	void add(Job&&);
+	bool takeOverflow(Job&);
+
+	BoundedQueue<Job> queue_;
+	StageStats stats_;
+
+	std::mutex overflowLock_;
+	std::deque<Job> overflow_;
+	std::atomic<size_t> overflowCount_{ 0 };
+	size_t overflowLimit_;
+
+	std::atomic<uint64_t> pushed_{ 0 };
+	std::atomic<uint64_t> done_{ 0 };
+
+	std::atomic_bool quit_{ false };
+	std::thread thread_;
+};
+
+/* Messages received by the network thread, decoded by a pool of workers and applied
+   back on the network thread in the order of arrival:
+
+     network receive -> decode workers -> solver (apply) -> storage
+
+   The network thread never waits: a message that does not fit into the queue is
+   parked, and it goes in with the ones after it as the applied ones free the slots.
+   The parked ones are bounded too; at their limit the network is not admitted any
+   more messages, it drops them and forgets it has seen them, so that they are taken
+   when sent again. Configured by the [pipeline] section:
+
+     decodeThreads=2
+     queueSize=1024       ; Messages between receive and apply
+     maxParked=4096       ; Messages held back beyond the queue
+     statsInterval=60     ; Seconds between the metrics lines, 0 to turn them off */
+class Pipeline {
+public:
+	typedef std::function<void()> Action;
+
+	// Turns the message bytes into the action to apply. The bytes stay valid
+	// until the action is applied
+	typedef std::function<Action(const char*, std::size_t)> Handler;
+
+	Pipeline();
+	~Pipeline();
+
+	void start(const boost::property_tree::ptree& config, std::function<void()> onWorkerStart = nullptr);
+
+	// False if the parked ones are at their limit, the caller drops the message then
+	// and it's counted
+	bool admit();
+
+	// Decoded by a worker. False if dropped, the parked ones at their limit
+	bool decode(const char* data, std::size_t size, Handler);
+
+	// Decoded at apply time, for the small messages
+	bool inOrder(const char* data, std::size_t size, Handler);
+
+	// Applies the decoded messages in order, at most the given number of them
+	void apply(size_t budget = 64);
+
+	// Other stages to include into the metrics lines
+	void addReported(const char* name, const SerialStage*);
+	void addReported(std::function<void(std::ostream&)>);
+
+	size_t depth() const { return produced_ - applied_; }
+
+private:
+	enum SlotState {
+		Free,
+		Queued,
+		Ready
+	};
+
+	struct Slot {
+		std::atomic<int> state{ Free };
+		bool heavy;
+
+		std::vector<char> data;
+		Handler handler;
+		Action action;
+
+		StageClock::time_point queued;
+		StageClock::time_point decoded;
+	};
+
+	// Waiting for a free slot, in the order of arrival
+	struct Parked {
+		std::vector<char> data;
+		Handler handler;
+		bool heavy;
+		StageClock::time_point queued;
+	};
+
+	bool push(const char* data, std::size_t size, Handler&&, bool heavy);
+	void place(Slot&, Handler&&, bool heavy, StageClock::time_point queued);
+	void unpark();
+	void decodeRoutine(std::function<void()> onStart);
+	void report();
+
+	std::unique_ptr<Slot[]> slots_;
+	size_t mask_ = 0;
+
+	uint64_t produced_ = 0;  // Network thread only
+	uint64_t applied_ = 0;
+
+	std::unique_ptr<BoundedQueue<uint64_t>> toDecode_;
+
+	std::deque<Parked> parked_;  // Network thread only
+	size_t parkedLimit_;
+	size_t maxParked_ = 0;
+
+	StageStats decodeStats_;
+	StageStats applyStats_;
+
+	std::vector<std::function<void(std::ostream&)>> reported_;
+	std::chrono::seconds statsInterval_{ 60 };
+	StageClock::time_point lastReport_;
+
+	std::atomic_bool quit_{ false };
+	std::vector<std::thread> workers_;
+};
+
+} // namespace Credits
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/ip/address.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace Credits {
+
+enum class RoundPhase {
+	RoundTable,        // The round started
+	FirstTransaction,
+	BlockCandidate,
+	Vector,            // Per sender
+	Matrix,            // Per sender
+	Writer,            // This node became the writer
+	BlockSent,
+	BlockReceived,
+	Hash,              // Per sender
+	Count
+};
+
+struct RoundEvent {
+	RoundPhase phase;
+	boost::asio::ip::address sender;  // Unspecified for the local events
+	std::chrono::microseconds offset;   // Since the round start
+};
+
+struct RoundRecord {
+	uint32_t round = 0;
+	int level = 0;
+	std::chrono::steady_clock::time_point start;
+	std::vector<RoundEvent> events;
+};
+
+/* When the phases of the recent rounds happened, as seen by this node. Every
+   [timeline] reportEvery rounds the percentiles of the phases and the slowest
+   senders go to the log and, if set, to dumpFile along with the rounds themselves:
+
+     depth=128           ; Rounds kept
+     reportEvery=100     ; 0 to turn the reports off
+     dumpFile=timeline.txt
+
+   Written by the network thread, may be read from any */
+class RoundTimeline {
+public:
+	RoundTimeline();
+
+	void load(const boost::property_tree::ptree& config);
+
+	void startRound(uint32_t round, int level);
+	void mark(RoundPhase, const boost::asio::ip::address& sender = boost::asio::ip::address());
+
+	std::vector<RoundRecord> getRecent() const;
+	bool getRound(uint32_t round, RoundRecord&) const;
+
+	void summarize(std::ostream&) const;
+	void dump(std::ostream&) const;
+
+	static const char* getPhaseName(RoundPhase);
+
+private:
+	void report() const;
+
+	size_t depth_;
+	uint32_t reportEvery_;
+	std::string dumpFile_;
+
+	uint32_t started_ = 0;
+
+	mutable std::mutex mutex_;
+	std::deque<RoundRecord> rounds_;
+};
+
+} // namespace Credits
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/pool.h>
+#include <csdb/transaction.h>
+
+#include "BoundedQueue.hpp"
+#include "Pipeline.hpp"
+
+namespace Credits {
+
+/* Signature checks of the incoming transactions and blocks, run by the decode workers
+   before the messages reach the solver. A big batch is split into chunks verified by
+   a pool of threads together with the caller; the first bad signature stops the rest
+   of the batch. Configured by the [verification] section:
+
+     enabled=false       ; Messages with bad signatures are dropped when on
+     threads=2           ; Helpers besides the calling thread
+     chunk=64            ; Transactions per chunk */
+class SignatureVerifier {
+public:
+	SignatureVerifier() = default;
+	~SignatureVerifier();
+
+	void start(const boost::property_tree::ptree& config, std::function<void()> onWorkerStart = nullptr);
+
+	bool isEnabled() const { return enabled_; }
+
+	// True if every signature is right. Thread-safe
+	bool verify(const std::vector<csdb::Transaction>&);
+	bool verify(csdb::Pool&);  // The writer's signature and the transactions
+
+	void report(std::ostream&) const;
+
+private:
+	struct Job {
+		const csdb::Transaction* transactions;
+		size_t size;
+
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> inFlight{ 0 };
+		std::atomic_bool failed{ false };
+	};
+
+	typedef std::shared_ptr<Job> JobPtr;
+
+	bool verify(const csdb::Transaction*, size_t size);
+
+	void work(Job&);
+	void workerRoutine(std::function<void()> onStart);
+
+	bool enabled_ = false;
+	size_t chunk_ = 64;
+
+	std::unique_ptr<BoundedQueue<JobPtr>> jobs_;
+
+	StageStats stats_;
+	std::atomic<uint64_t> signatures_{ 0 };
+	std::atomic<uint64_t> failures_{ 0 };
+
+	std::atomic_bool quit_{ false };
+	std::vector<std::thread> workers_;
+};
+
+} // namespace Credits
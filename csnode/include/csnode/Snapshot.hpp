@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/address.h>
+#include <csdb/amount.h>
+#include <csdb/pool.h>
+#include <csdb/transaction.h>
+
+namespace Credits {
+
+/* Serialization of the snapshot parts, in the byte order of the node. The plain
+   values, csdb::Amount among them, are copied as they are */
+class SnapshotWriter {
+public:
+	template <typename T>
+	SnapshotWriter& operator<<(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Not a plain value");
+		data_.append((const char*)&value, sizeof(T));
+		return *this;
+	}
+
+	SnapshotWriter& operator<<(const std::string&);
+	SnapshotWriter& operator<<(const csdb::PoolHash&);
+	SnapshotWriter& operator<<(const csdb::Address&);
+	SnapshotWriter& operator<<(const csdb::TransactionID&);
+
+	std::string& data() { return data_; }
+
+private:
+	std::string data_;
+};
+
+class SnapshotReader {
+public:
+	SnapshotReader(const char* data, size_t size) : ptr_(data), end_(data + size) { }
+
+	template <typename T>
+	SnapshotReader& operator>>(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Not a plain value");
+		if ((size_t)(end_ - ptr_) < sizeof(T)) good_ = false;
+		else {
+			memcpy(&value, ptr_, sizeof(T));
+			ptr_ += sizeof(T);
+		}
+
+		return *this;
+	}
+
+	SnapshotReader& operator>>(std::string&);
+	SnapshotReader& operator>>(csdb::PoolHash&);
+	SnapshotReader& operator>>(csdb::Address&);
+	SnapshotReader& operator>>(csdb::TransactionID&);
+
+	bool good() const { return good_; }
+	bool end() const { return ptr_ == end_; }
+
+private:
+	const char* ptr_;
+	const char* end_;
+	bool good_ = true;
+};
+
+/* Runtime state saved every few rounds and restored at startup, so a restarted
+   node does not walk the whole chain again to rebuild its caches and indices.
+   The file is tagged with the hash of the last block, and is used only if it is
+   still the last one. Every part is restored by its owner as it is created, and
+   saved by the saver the owner has added. Configured by the optional [snapshot]
+   section:
+
+     enabled=false
+     path=snapshot.bin
+     interval=100        ; Rounds between the saves */
+class Snapshot {
+public:
+	typedef std::function<void(SnapshotWriter&)> Saver;
+
+	// Reads everything the part has written, false if the data is bad
+	typedef std::function<bool(SnapshotReader&)> Loader;
+
+	Snapshot();
+
+	// Reads the file, if it matches the last block
+	void load(const boost::property_tree::ptree& config, const csdb::PoolHash& lastHash);
+
+	bool isEnabled() const { return enabled_; }
+	bool isDue(uint32_t round) const { return enabled_ && interval_ && round % interval_ == 0; }
+
+	// False if the part is not in the snapshot or the loader has failed, then the
+	// owner builds its state as without a snapshot
+	bool restore(const std::string& name, const Loader&) const;
+
+	// The saver runs on the thread calling capture(), the first one added for a name is kept
+	void addPart(const std::string& name, Saver);
+
+	// Serializes all the parts, the loaded ones are not kept from now on
+	std::string capture();
+
+	// Writes the captured parts with the hash of the block they are consistent with
+	void write(const csdb::PoolHash& lastHash, const std::string& captured) const;
+
+private:
+	bool enabled_ = false;
+	std::string path_;
+	uint32_t interval_;
+
+	std::map<std::string, std::string> loaded_;
+	std::map<std::string, Saver> savers_;
+};
+
+} // namespace Credits
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace Credits {
+
+enum class StartupPhase {
+	StorageReady,  // The chain is opened and consistent
+	NetworkReady,  // The ring and the round came from the signal server
+	ApiReady,      // The API takes requests, the caches are built on demand until warm
+	CachesWarm,    // All the warm-ups are done
+	Count
+};
+
+/* Readiness of the node as it starts. The node registers with the network as soon
+   as the storage is ready, while the caches are warmed up in the background, each
+   one in its own thread. The phases may be checked from any thread */
+class Startup {
+public:
+	typedef std::function<void()> WarmUp;
+
+	Startup();
+	~Startup();  // Waits for the warm-ups
+
+	void reach(StartupPhase);
+	bool isReady(StartupPhase phase) const { return reachedMs_[(size_t)phase].load() >= 0; }
+
+	void addWarmUp(const char* name, WarmUp);
+
+	// Every thread runs onThreadStart first
+	void startWarmUps(std::function<void()> onThreadStart = nullptr);
+
+private:
+	struct Task {
+		const char* name;
+		WarmUp warmUp;
+	};
+
+	int64_t elapsedMs() const;
+
+	const std::chrono::steady_clock::time_point start_;
+	std::atomic<int64_t> reachedMs_[(size_t)StartupPhase::Count];  // -1 until reached
+
+	std::vector<Task> tasks_;
+	std::atomic<size_t> pending_{ 0 };
+	std::vector<std::thread> threads_;
+};
+
+} // namespace Credits
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace Credits {
+
+enum class ThreadRole {
+	Other,      // Everything not listed below, inherited from the main thread
+	Network,    // Asio poll loop and the sender routine
+	Storage,    // csdb write thread
+	Stats,      // csstats collector
+	Api,        // Thrift server accept loop
+	ApiClient,  // Thrift per-connection threads
+	Decode,     // Message decoding workers
+	Count
+};
+
+enum class ThreadPriority {
+	Normal,
+	Low,
+	High
+};
+
+/* CPU affinity and scheduling priority of the node threads, configured by the optional
+   [threads] section of Configure.ini:
+
+     network=3                ; CPU list, like "0-2,5"
+     networkPriority=high     ; normal, low or high
+     storage=0-1
+     isolateNetwork=true      ; No other thread runs on the network CPUs
+
+   Roles without a CPU list run on all the CPUs, or on all but the network ones when
+   the network is isolated. Threads created by third-party code inherit the placement
+   of the main thread, which is set to the Other role before the node starts */
+class ThreadTopology {
+public:
+	bool load(const boost::property_tree::ptree& config);
+
+	bool apply(ThreadRole, std::thread::native_handle_type) const;
+	bool applyToCurrent(ThreadRole) const;
+
+	bool isEnabled() const { return enabled_; }
+
+	static const char* getRoleName(ThreadRole);
+
+private:
+	struct Placement {
+		std::vector<unsigned> cpus;
+		ThreadPriority priority = ThreadPriority::Normal;
+	};
+
+	const Placement& getPlacement(ThreadRole role) const { return placements_[(size_t)role]; }
+
+	bool enabled_ = false;
+	Placement placements_[(size_t)ThreadRole::Count];
+};
+
+} // namespace Credits
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/transaction.h>
+
+namespace Credits {
+
+/* Outgoing transactions gathered into one message to the main node. The batch goes
+   when it is big enough, has waited long enough or the round changes. Configured by
+   the optional [coalescing] section:
+
+     maxCount=1000
+     maxBytes=62440      ; Serialized, one packet by default
+     maxDelay=10         ; Milliseconds, 0 sends every transaction at once */
+class TransactionCoalescer {
+public:
+	enum Reason {
+		Count,
+		Size,
+		Timeout,
+		Round,
+		ReasonsNum
+	};
+
+	typedef std::function<void(std::vector<csdb::Transaction>&&)> Sender;
+
+	explicit TransactionCoalescer(Sender);
+
+	void load(const boost::property_tree::ptree& config);
+
+	void add(const csdb::Transaction&);
+
+	// Sends the batch if it has waited long enough
+	void poll();
+
+	void flush(Reason);
+
+	void report(std::ostream&) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	Sender sender_;
+
+	size_t maxCount_;
+	size_t maxBytes_;
+	std::chrono::milliseconds maxDelay_;
+
+	std::vector<csdb::Transaction> batch_;
+	size_t bytes_ = 0;
+	Clock::time_point started_;
+
+	uint64_t sent_ = 0;
+	uint64_t flushes_[ReasonsNum] = {};
+};
+
+} // namespace Credits
@@ -0,0 +1,263 @@
+#include <algorithm>
+
+#include "csnode/BalanceCache.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_APPLY_THREADS = 2;
+const size_t DEFAULT_SHARDS = 64;
+
+// Pending help requests, one per helper at most for every block
+const size_t JOBS_QUEUE_SIZE = 64;
+
+BalanceCache::BalanceCache() :
+	shards_(new Shard[DEFAULT_SHARDS]),
+	shardsCount_(DEFAULT_SHARDS),
+	threads_(DEFAULT_APPLY_THREADS) { }
+
+BalanceCache::~BalanceCache() {
+	quit_ = true;
+	for (auto& worker : workers_)
+		if (worker.joinable()) worker.join();
+}
+
+void BalanceCache::load(const boost::property_tree::ptree& config, const csdb::PoolHash& tip) {
+	auto section = config.get_child_optional("apply");
+	if (section) {
+		threads_ = section->get<size_t>("threads", threads_);
+
+		const size_t shards = std::max<size_t>(section->get<size_t>("shards", shardsCount_), 1);
+		if (shards != shardsCount_) {
+			shards_.reset(new Shard[shards]);
+			shardsCount_ = shards;
+		}
+	}
+
+	for (size_t i = 0; i < shardsCount_; ++i)
+		shards_[i].tip = tip;
+}
+
+void BalanceCache::start(std::function<void()> onWorkerStart) {
+	if (!threads_) return;
+
+	jobs_.reset(new BoundedQueue<JobPtr>(JOBS_QUEUE_SIZE));
+	for (size_t i = 0; i < threads_; ++i)
+		workers_.emplace_back(&BalanceCache::workerRoutine, this, onWorkerStart);
+}
+
+BalanceCache::Shard& BalanceCache::getShard(const csdb::Address& address) const {
+	// FNV-1a of the key
+	uint64_t hash = 14695981039346656037ull;
+	for (auto byte : address.public_key())
+		hash = (hash ^ byte) * 1099511628211ull;
+
+	return shards_[hash % shardsCount_];
+}
+
+bool BalanceCache::get(const csdb::Address& address, Balance& balance) const {
+	Shard& shard = getShard(address);
+	std::lock_guard<std::mutex> l(shard.lock);
+
+	auto it = shard.balances.find(address);
+	if (it == shard.balances.end()) return false;
+
+	balance = it->second.balance;
+	if (it->second.followed) balance.hash = shard.tip;
+
+	return true;
+}
+
+void BalanceCache::put(const csdb::Address& address, const Balance& balance) {
+	Shard& shard = getShard(address);
+	std::lock_guard<std::mutex> l(shard.lock);
+
+	// Walked to a block the shard is not at, it is not followed till a block touches it
+	shard.balances[address] = Entry{ balance, balance.hash == shard.tip };
+}
+
+void BalanceCache::apply(csdb::Pool& pool) {
+	const auto started = StageClock::now();
+
+	std::vector<std::vector<Effect>> effects(shardsCount_);
+	for (auto& trans : pool.transactions()) {
+		effects[&getShard(trans.source()) - shards_.get()].push_back(Effect{ &trans, true });
+
+		// Walking the chain back, a transfer to itself is only the source
+		if (trans.target() != trans.source())
+			effects[&getShard(trans.target()) - shards_.get()].push_back(Effect{ &trans, false });
+	}
+
+	auto job = std::make_shared<Job>();
+	job->pool = &pool;
+	job->effects = &effects;
+
+	// Asks for help with the shards, as many helpers as there are
+	if (jobs_) {
+		const size_t helpers = std::min(workers_.size(), shardsCount_ - 1);
+		for (size_t i = 0; i < helpers && jobs_->tryPush(JobPtr(job)); ++i);
+	}
+
+	work(*job);
+
+	// Helpers may still be finishing the shards they took
+	Backoff backoff;
+	while (job->inFlight.load() != 0)
+		backoff.wait();
+
+	stats_.add(started, started, StageClock::now());
+	blocks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BalanceCache::work(Job& job) {
+	++job.inFlight;
+
+	// The pool and the effects are only touched within a taken shard, so the
+	// caller may leave once nothing is in flight
+	for (;;) {
+		const size_t shard = job.next.fetch_add(1);
+		if (shard >= shardsCount_) break;
+
+		applyShard(shards_[shard], *job.pool, (*job.effects)[shard]);
+	}
+
+	--job.inFlight;
+}
+
+void BalanceCache::applyShard(Shard& shard, const csdb::Pool& pool, const std::vector<Effect>& effects) {
+	struct Change {
+		bool source = false;
+		csdb::Amount recorded;
+		csdb::Amount incoming;
+	};
+
+	// The last balance recorded by the address as the source, and what it got
+	std::map<csdb::Address, Change> changes;
+	for (auto& effect : effects) {
+		const csdb::Transaction& trans = *effect.transaction;
+
+		if (effect.source) {
+			Change& change = changes[trans.source()];
+			change.source = true;
+			change.recorded = trans.balance();
+		}
+		else
+			changes[trans.target()].incoming += trans.amount();
+	}
+
+	const csdb::PoolHash hash = pool.hash();
+	const csdb::PoolHash previous = pool.previous_hash();
+
+	std::lock_guard<std::mutex> l(shard.lock);
+
+	// The untouched followed ones go along with the tip. Not after a gap, they are
+	// left as of the old tip then
+	const bool following = shard.tip == previous;
+	if (!following)
+		for (auto& balance : shard.balances)
+			if (balance.second.followed) {
+				balance.second.balance.hash = shard.tip;
+				balance.second.followed = false;
+			}
+
+	shard.tip = hash;
+
+	for (auto& change : changes) {
+		if (change.second.source) {
+			shard.balances[change.first] = Entry{ Balance{ hash, change.second.recorded + change.second.incoming }, true };
+			continue;
+		}
+
+		auto it = shard.balances.find(change.first);
+		if (it == shard.balances.end()) continue;
+
+		// Walked to this block already
+		Entry& entry = it->second;
+		if (entry.balance.hash == hash)
+			entry.followed = true;
+		else if (entry.followed || entry.balance.hash == previous) {
+			entry.balance.hash = hash;
+			entry.balance.amount += change.second.incoming;
+			entry.followed = true;
+		}
+	}
+}
+
+void BalanceCache::workerRoutine(std::function<void()> onStart) {
+	if (onStart) onStart();
+
+	Backoff backoff;
+	JobPtr job;
+
+	while (!quit_) {
+		if (!jobs_->tryPop(job)) {
+			backoff.wait();
+			continue;
+		}
+
+		backoff.reset();
+		work(*job);
+		job.reset();
+	}
+}
+
+size_t BalanceCache::size() const {
+	size_t result = 0;
+	for (size_t i = 0; i < shardsCount_; ++i) {
+		std::lock_guard<std::mutex> l(shards_[i].lock);
+		result += shards_[i].balances.size();
+	}
+
+	return result;
+}
+
+void BalanceCache::shrink(size_t count) {
+	const size_t perShard = count / shardsCount_;
+
+	for (size_t i = 0; i < shardsCount_; ++i) {
+		std::lock_guard<std::mutex> l(shards_[i].lock);
+
+		auto& balances = shards_[i].balances;
+		while (balances.size() > perShard)
+			balances.erase(std::prev(balances.end()));
+	}
+}
+
+void BalanceCache::write(SnapshotWriter& out) const {
+	std::vector<std::unique_lock<std::mutex>> locks;
+	size_t count = 0;
+
+	for (size_t i = 0; i < shardsCount_; ++i) {
+		locks.emplace_back(shards_[i].lock);
+		count += shards_[i].balances.size();
+	}
+
+	out << (uint64_t)count;
+	for (size_t i = 0; i < shardsCount_; ++i)
+		for (auto& balance : shards_[i].balances) {
+			const Entry& entry = balance.second;
+			out << balance.first << (entry.followed ? shards_[i].tip : entry.balance.hash) << entry.balance.amount;
+		}
+}
+
+bool BalanceCache::read(SnapshotReader& in) {
+	uint64_t count = 0;
+	in >> count;
+
+	for (uint64_t i = 0; i < count && in.good(); ++i) {
+		csdb::Address address;
+		Balance balance;
+		in >> address >> balance.hash >> balance.amount;
+
+		if (in.good())
+			put(address, balance);
+	}
+
+	return in.good() && in.end();
+}
+
+void BalanceCache::report(std::ostream& os) const {
+	stats_.report(os, "apply", jobs_ ? jobs_->size() : 0);
+	os << ", " << blocks_.load() << " blocks, " << size() << " balances";
+}
+
+} // namespace Credits
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <vector>
+
+#include "csnode/BlockAssembler.hpp"
+
+#include <net/Packet.hpp>
+
+namespace Credits {
+
+const size_t DEFAULT_MAX_BLOCKS = 4;
+const size_t ASSEMBLY_QUEUE_SIZE = 4096;
+
+BlockAssembler::BlockAssembler() :
+	maxBlocks_(DEFAULT_MAX_BLOCKS),
+	stage_(ASSEMBLY_QUEUE_SIZE) { }
+
+void BlockAssembler::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("assembly");
+	if (!section) return;
+
+	enabled_ = section->get<bool>("enabled", enabled_);
+	maxBlocks_ = std::max<size_t>(section->get<size_t>("maxBlocks", maxBlocks_), 1);
+}
+
+void BlockAssembler::addFragment(const Hash& key, size_t index, size_t count, const char* data, size_t size) {
+	BlockPtr block;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (index == 0) {
+			if (blocks_.size() >= maxBlocks_)
+				blocks_.pop_front();
+
+			block = std::make_shared<Block>();
+			block->key = key;
+			block->count = count;
+			blocks_.push_back(block);
+		}
+		else {
+			auto it = std::find_if(blocks_.rbegin(), blocks_.rend(), [&key](const BlockPtr& b) { return b->key == key; });
+			if (it == blocks_.rend()) return;  // Dropped
+
+			block = *it;
+		}
+	}
+
+	// The packets are not to be touched out of the network thread
+	std::vector<char> bytes(data, data + size);
+	++block->pushed;
+
+	const bool taken = stage_.tryPush([block, bytes]() {
+		if (block->fed == 0)
+			block->reader.reserve(block->count * max_length);
+
+		block->reader.feed(bytes.data(), bytes.size());
+		++block->fed;
+	});
+
+	// The stage is too far behind, the block is read whole instead
+	if (!taken) {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = std::find(blocks_.begin(), blocks_.end(), block);
+		if (it != blocks_.end()) blocks_.erase(it);
+	}
+}
+
+bool BlockAssembler::take(const Hash& key, csdb::Pool& pool) {
+	BlockPtr block;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = std::find_if(blocks_.rbegin(), blocks_.rend(), [&key](const BlockPtr& b) { return b->key == key; });
+		if (it != blocks_.rend()) {
+			block = *it;
+			blocks_.erase(std::next(it).base());
+		}
+	}
+
+	// A message may also complete by stream, with its fragments still missing
+	if (!block || block->pushed.load() < block->count) {
+		++missed_;
+		return false;
+	}
+
+	Backoff backoff;
+	while (block->fed.load() < block->count)
+		backoff.wait();
+
+	if (!block->reader.finish(pool)) {
+		++missed_;
+		return false;
+	}
+
+	++assembled_;
+	return true;
+}
+
+void BlockAssembler::report(std::ostream& os) const {
+	stage_.getStats().report(os, "assembly", stage_.depth());
+	os << ", " << assembled_.load() << " assembled, " << missed_.load() << " read whole";
+}
+
+} // namespace Credits
@@ -2,55 +2,158 @@
 #include <net/Hash.hpp>
 
 #include "csnode/Blockchain.hpp"
+#include "csnode/PerfCounters.hpp"
 
 #include "sys/timeb.h"
 
 namespace Credits {
 
-BlockChain::BlockChain(const char* path) {
+const size_t STORAGE_QUEUE_SIZE = 64;
+
+// With the tree node and the bytes of the address and the hash
+const size_t BALANCE_ENTRY_BYTES = 256;
+
+BlockChain::BlockChain(const char* path, const boost::property_tree::ptree& config) : storageStage_(STORAGE_QUEUE_SIZE) {
 	std::cerr << "Trying to open DB..." << std::endl;
 	if (storage_.open(path))
 		good_ = true;
-	else
+	else {
 		LOG_ERROR("Couldn't open database at " << path);
+		return;
+	}
+
+	tipHash_ = storage_.last_hash();
+	tipSize_ = storage_.size();
+
+	snapshot_.load(config, tipHash_);
+	balances_.load(config, tipHash_);
+
+	// Every entry is checked against its own block, the balances are valid as they are
+	snapshot_.restore("balances", [this](SnapshotReader& in) { return balances_.read(in); });
+	snapshot_.addPart("balances", [this](SnapshotWriter& out) { balances_.write(out); });
+
+	memoryBudget_.load(config);
+
+	memoryBudget_.addPart("balances", MemoryBudget::Normal,
+		[this]() { return balances_.size() * BALANCE_ENTRY_BYTES; },
+		[this](size_t bytes) { balances_.shrink(bytes / BALANCE_ENTRY_BYTES); });
+
+	memoryBudget_.addPart("database", MemoryBudget::High,
+		[this]() {
+			std::lock_guard<std::mutex> l(dbLock_);
+			return storage_.cache_size();
+		},
+		[this](size_t bytes) {
+			std::lock_guard<std::mutex> l(dbLock_);
+			if (!storage_.set_cache_size(bytes))
+				LOG_WARN("Couldn't resize the database cache: " << storage_.last_error_message());
+		});
+}
+
+void BlockChain::saveSnapshot() {
+	storageStage_.push([this, captured = snapshot_.capture()]() {
+		csdb::PoolHash lastHash;
+		{
+			std::lock_guard<std::mutex> l(dbLock_);
+			lastHash = storage_.last_hash();
+		}
+
+		snapshot_.write(lastHash, captured);
+	});
 }
 
 void BlockChain::writeLastBlock(csdb::Pool&& pool) {
+	{
+		std::lock_guard<std::mutex> l(tipLock_);
+
+		pool.set_previous_hash(tipHash_);
+		pool.set_sequence(tipSize_);
+
+		if (!pool.compose()) {
+			LOG_ERROR("Couldn't compose block");
+			return;
+		}
+
+		tipHash_ = pool.hash();
+		++tipSize_;
+		queued_.push_back(pool);
+	}
+
+	storageStage_.push([this, pool = std::move(pool)]() mutable { save(pool); });
+}
+
+void BlockChain::save(csdb::Pool& pool) {
+	PerfScope perf(PerfStage::Storage);
+
+	// The composed pool is shared with the queued ones, saved without changing it
 	std::lock_guard<std::mutex> l(dbLock_);
+	const bool saved = storage_.pool_save(pool);
 
-	pool.set_storage(storage_);
-	pool.set_previous_hash(storage_.last_hash());
-	pool.set_sequence(storage_.size());
+	{
+		std::lock_guard<std::mutex> t(tipLock_);
+		queued_.pop_front();
 
-	if (!pool.compose())
-		LOG_ERROR("Couldn't compose block");
+		// The ones composed on top of it are saved still, unlinked
+		if (!saved && queued_.empty()) {
+			tipHash_ = storage_.last_hash();
+			tipSize_ = storage_.size();
+		}
+	}
 
-	if (!pool.save())
+	if (!saved) {
 		LOG_ERROR("Couldn't save block");
+		return;
+	}
+
+	balances_.apply(pool);
+}
+
+bool BlockChain::findQueued(const csdb::PoolHash& ph, csdb::Pool& pool) {
+	std::lock_guard<std::mutex> l(tipLock_);
+
+	for (auto& queued : queued_)
+		if (queued.hash() == ph) {
+			pool = queued;
+			return true;
+		}
+
+	return false;
 }
 
 csdb::PoolHash BlockChain::getLastHash() {
-	std::lock_guard<std::mutex> l(dbLock_);
-	return storage_.last_hash();
+	std::lock_guard<std::mutex> l(tipLock_);
+	return tipHash_;
 }
 
 size_t BlockChain::getSize() {
-	std::lock_guard<std::mutex> l(dbLock_);
-	return storage_.size();
+	std::lock_guard<std::mutex> l(tipLock_);
+	return tipSize_;
 }
 
 csdb::Pool BlockChain::loadBlock(const csdb::PoolHash& ph) {
+	csdb::Pool queued;
+	if (findQueued(ph, queued)) return queued;
+
 	std::lock_guard<std::mutex> l(dbLock_);
 	auto pool = storage_.pool_load(ph);
 	return pool;
 }
 
 csdb::Pool BlockChain::loadBlockMeta(const csdb::PoolHash& ph, size_t& cnt) {
+	csdb::Pool queued;
+	if (findQueued(ph, queued)) {
+		cnt = queued.transactions_count();
+		return queued;
+	}
+
 	std::lock_guard<std::mutex> l(dbLock_);
 	return storage_.pool_load_meta(ph, cnt);
 }
 
 csdb::Transaction BlockChain::loadTransaction(const csdb::TransactionID& transId) {
+	csdb::Pool queued;
+	if (findQueued(transId.pool_hash(), queued)) return queued.transaction(transId);
+
 	std::lock_guard<std::mutex> l(dbLock_);
 	return storage_.transaction(transId);
 }
@@ -66,10 +169,10 @@ csdb::Amount BlockChain::getBalance(const csdb::Address& address) {
 
 	csdb::PoolHash lastHash = getLastHash();
 
-	auto cacheIter = balancesCache_.find(address);
-	if (cacheIter != balancesCache_.end()) {
-		lastCheckedHash = cacheIter->second.first;
-		cachedBalance = cacheIter->second.second;
+	BalanceCache::Balance cached;
+	if (balances_.get(address, cached)) {
+		lastCheckedHash = cached.hash;
+		cachedBalance = cached.amount;
 
 		if (lastCheckedHash == lastHash) return cachedBalance;
 	}
@@ -100,7 +203,8 @@ csdb::Amount BlockChain::getBalance(const csdb::Address& address) {
 	}
 
 	if (!foundSource) result += cachedBalance;
-	balancesCache_[address] = std::make_pair(lastHash, result);
+
+	balances_.put(address, BalanceCache::Balance{ lastHash, result });
 
 	return result;
 }
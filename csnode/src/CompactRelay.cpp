@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+#include <sodium.h>
+
+#include "csnode/CompactRelay.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_KEEP = 65536;
+const size_t DEFAULT_SENT_KEPT = 8;
+
+static_assert(sizeof(ShortIdKey) == crypto_shorthash_KEYBYTES, "Wrong short id key size");
+static_assert(sizeof(ShortTransactionId) == crypto_shorthash_BYTES, "Wrong short id size");
+
+const ShortTransactionId SHORT_ID_MASK = (ShortTransactionId(1) << (SHORT_ID_BYTES * 8)) - 1;
+
+TransactionDigest getDigest(const csdb::Transaction& trans) {
+	return cscrypto::blake2s(trans.to_byte_stream());
+}
+
+static ShortTransactionId getShortId(const TransactionDigest& digest, const ShortIdKey& key) {
+	ShortTransactionId id;
+	crypto_shorthash((unsigned char*)&id, digest.data(), digest.size(), key.data());
+	return id & SHORT_ID_MASK;
+}
+
+static TransactionDigest getChecksum(const std::vector<TransactionDigest>& digests) {
+	return cscrypto::blake2s((const cscrypto::byte*)digests.data(), digests.size() * sizeof(TransactionDigest));
+}
+
+ShortIdKey CompactCandidate::getKey() const {
+	ShortIdKey key;
+	memcpy(key.data(), &salt, sizeof(salt));
+	memcpy(key.data() + sizeof(salt), checksum.data(), key.size() - sizeof(salt));
+	return key;
+}
+
+/* PartialCandidate */
+
+bool PartialCandidate::fill(std::vector<csdb::Transaction>&& fetched) {
+	if (fetched.size() != missing.size()) return false;
+
+	for (size_t i = 0; i < missing.size(); ++i) {
+		transactions[missing[i]] = std::move(fetched[i]);
+		digests[missing[i]] = getDigest(transactions[missing[i]]);
+	}
+
+	missing.clear();
+	return true;
+}
+
+bool PartialCandidate::build(csdb::Pool& pool) const {
+	if (!missing.empty() || getChecksum(digests).bytes != compact.checksum.bytes)
+		return false;
+
+	const csdb::Pool& header = compact.header;
+
+	pool = csdb::Pool(header.previous_hash(), header.sequence());
+	pool.set_writer_public_key(header.writer_public_key());
+	for (auto id : header.user_field_ids())
+		pool.add_user_field(id, header.user_field(id));
+
+	for (auto& trans : transactions)
+		if (!pool.add_transaction(trans)) return false;
+
+	return true;
+}
+
+void PartialCandidate::missAll() {
+	missing.resize(transactions.size());
+	std::fill(transactions.begin(), transactions.end(), csdb::Transaction());
+
+	for (uint32_t i = 0; i < missing.size(); ++i)
+		missing[i] = i;
+}
+
+/* CompactRelay */
+
+CompactRelay::CompactRelay() :
+	keep_(DEFAULT_KEEP),
+	sentKept_(DEFAULT_SENT_KEPT) { }
+
+void CompactRelay::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("compact");
+	if (!section) return;
+
+	enabled_ = section->get<bool>("enabled", enabled_);
+	keep_ = section->get<size_t>("keep", keep_);
+	sentKept_ = std::max<size_t>(section->get<size_t>("sentKept", sentKept_), 1);
+}
+
+void CompactRelay::addSeen(const std::vector<csdb::Transaction>& transactions) {
+	if (!keep_) return;
+
+	// Hashed before taking the lock, the workers add in parallel
+	std::vector<Seen> added;
+	added.reserve(transactions.size());
+	for (auto& trans : transactions)
+		added.push_back(Seen{ getDigest(trans), trans });
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for (auto& seen : added) {
+		if (seen_.size() >= keep_)
+			seen_.pop_front();
+
+		seen_.push_back(std::move(seen));
+	}
+}
+
+PartialCandidate CompactRelay::rebuild(CompactCandidate&& compact) const {
+	PartialCandidate result;
+	result.transactions.resize(compact.ids.size());
+	result.digests.resize(compact.ids.size());
+
+	// The ids are salted anew for every candidate, so the index is built each time.
+	// Ids met twice, locally or in the candidate, are fetched to avoid a wrong guess
+	const size_t ambiguous = size_t(-1);
+	std::unordered_map<ShortTransactionId, size_t> wanted;
+	wanted.reserve(compact.ids.size());
+
+	for (size_t i = 0; i < compact.ids.size(); ++i) {
+		auto inserted = wanted.emplace(compact.ids[i], i);
+		if (!inserted.second) inserted.first->second = ambiguous;
+	}
+
+	const ShortIdKey key = compact.getKey();
+	std::vector<const Seen*> found(compact.ids.size(), nullptr);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		for (auto& seen : seen_) {
+			auto it = wanted.find(getShortId(seen.digest, key));
+			if (it == wanted.end() || it->second == ambiguous) continue;
+
+			const Seen*& match = found[it->second];
+			if (match && match->digest.bytes != seen.digest.bytes) {  // Two local transactions with the same id
+				match = nullptr;
+				it->second = ambiguous;
+				continue;
+			}
+
+			match = &seen;
+		}
+
+		for (uint32_t i = 0; i < found.size(); ++i) {
+			if (!found[i]) {
+				result.missing.push_back(i);
+				continue;
+			}
+
+			result.transactions[i] = found[i]->transaction;
+			result.digests[i] = found[i]->digest;
+		}
+	}
+
+	result.compact = std::move(compact);
+
+	++candidates_;
+	found_ += result.transactions.size() - result.missing.size();
+	missed_ += result.missing.size();
+
+	return result;
+}
+
+CompactCandidate CompactRelay::makeCandidate(const csdb::Pool& pool) {
+	static std::mt19937_64 random(std::random_device{}());
+
+	CompactCandidate result;
+	result.salt = random();
+
+	auto& transactions = const_cast<csdb::Pool&>(pool).transactions();
+
+	std::vector<TransactionDigest> digests;
+	digests.reserve(transactions.size());
+	for (auto& trans : transactions)
+		digests.push_back(getDigest(trans));
+
+	result.checksum = getChecksum(digests);
+
+	const ShortIdKey key = result.getKey();
+	result.ids.reserve(digests.size());
+	for (auto& digest : digests)
+		result.ids.push_back(getShortId(digest, key));
+
+	result.header = csdb::Pool(pool.previous_hash(), pool.sequence());
+	result.header.set_writer_public_key(pool.writer_public_key());
+	for (auto id : pool.user_field_ids())
+		result.header.add_user_field(id, pool.user_field(id));
+
+	if (sent_.size() >= sentKept_)
+		sent_.pop_front();
+	sent_.push_back(Sent{ result.salt, pool });
+
+	return result;
+}
+
+bool CompactRelay::getTransactions(uint64_t salt, const std::vector<uint32_t>& indices, std::vector<csdb::Transaction>& result) const {
+	auto sent = std::find_if(sent_.begin(), sent_.end(), [salt](const Sent& s) { return s.salt == salt; });
+	if (sent == sent_.end()) return false;
+
+	auto& transactions = const_cast<csdb::Pool&>(sent->pool).transactions();
+
+	result.clear();
+	result.reserve(indices.size());
+
+	for (auto index : indices) {
+		if (index >= transactions.size()) return false;
+		result.push_back(transactions[index]);
+	}
+
+	return true;
+}
+
+void CompactRelay::setPending(PartialCandidate&& candidate) {
+	pending_ = std::move(candidate);
+	hasPending_ = true;
+	++requests_;
+}
+
+void CompactRelay::dropPending() {
+	pending_ = PartialCandidate();
+	hasPending_ = false;
+}
+
+void CompactRelay::onRoundStart() {
+	dropPending();
+	sent_.clear();
+}
+
+void CompactRelay::report(std::ostream& os) const {
+	os << "compact: " << candidates_.load() << " candidates, " << found_.load() << " found, "
+	   << missed_.load() << " fetched in " << requests_ << " requests";
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	os << ", " << seen_.size() << " kept";
+}
+
+} // namespace Credits
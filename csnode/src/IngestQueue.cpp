@@ -0,0 +1,73 @@
+#include <algorithm>
+
+#include "csnode/IngestQueue.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_INGEST_QUEUE_SIZE = 4096;
+const size_t DEFAULT_INGEST_BATCH = 256;
+const uint32_t DEFAULT_INGEST_TIMEOUT_SEC = 5;
+
+IngestQueue::IngestQueue(const boost::property_tree::ptree& config) :
+	queue_(config.get<size_t>("ingest.queueSize", DEFAULT_INGEST_QUEUE_SIZE)),
+	batch_(std::max<size_t>(config.get<size_t>("ingest.batch", DEFAULT_INGEST_BATCH), 1)),
+	timeout_(config.get<uint32_t>("ingest.timeout", DEFAULT_INGEST_TIMEOUT_SEC)) { }
+
+std::future<bool> IngestQueue::push(csdb::Transaction transaction) {
+	Request request;
+	request.transaction = std::move(transaction);
+	auto result = request.taken.get_future();
+
+	if (!queue_.tryPush(std::move(request))) {
+		++full_;
+
+		std::promise<bool> rejected;
+		rejected.set_value(false);
+		return rejected.get_future();
+	}
+
+	++pushed_;
+	return result;
+}
+
+bool IngestQueue::submit(csdb::Transaction transaction) {
+	auto taken = push(std::move(transaction));
+
+	if (taken.wait_for(timeout_) != std::future_status::ready) {
+		++timedOut_;
+		return false;
+	}
+
+	// Broken if the node is gone meanwhile
+	try {
+		return taken.get();
+	}
+	catch (const std::future_error&) {
+		return false;
+	}
+}
+
+size_t IngestQueue::drain(const Consumer& consumer) {
+	Request request;
+	size_t count = 0;
+
+	while (count < batch_ && queue_.tryPop(request)) {
+		consumer(std::move(request.transaction));
+		request.taken.set_value(true);
+		++count;
+	}
+
+	if (count) {
+		taken_ += count;
+		++ticks_;
+	}
+
+	return count;
+}
+
+void IngestQueue::report(std::ostream& os) const {
+	os << "ingest: " << pushed_.load() << " pushed, " << taken_ << " taken in " << ticks_ << " batches, "
+	   << queue_.size() << " queued, " << full_.load() << " full, " << timedOut_.load() << " timed out";
+}
+
+} // namespace Credits
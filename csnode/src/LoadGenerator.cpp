@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+
+#include <ed25519.h>
+
+#include <csdb/currency.h>
+#include <net/Logger.hpp>
+
+#include "csnode/LoadGenerator.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_WALLETS = 100;
+const double DEFAULT_RATE = 100;
+const size_t DEFAULT_PRESIGNED = 10000;
+const uint32_t DEFAULT_TIMEOUT_SEC = 60;
+
+// Bounds a single poll after a stall
+const uint64_t MAX_BURST = 10000;
+
+LoadGenerator::~LoadGenerator() {
+	quit_ = true;
+	if (signer_.joinable()) signer_.join();
+}
+
+void LoadGenerator::start(const boost::property_tree::ptree& config, Sender sender, std::function<void()> onSignerStart) {
+	auto section = config.get_child_optional("load");
+	if (!section) return;
+
+	enabled_ = section->get<bool>("enabled", enabled_);
+	if (!enabled_) return;
+
+	const size_t wallets = std::max<size_t>(section->get<size_t>("wallets", DEFAULT_WALLETS), 2);
+	rate_ = section->get<double>("rate", DEFAULT_RATE);
+	timeout_ = std::chrono::seconds(section->get<uint32_t>("timeout", DEFAULT_TIMEOUT_SEC));
+
+	wallets_.resize(wallets);
+	for (auto& wallet : wallets_) {
+		wallet.keys = cscrypto::generateKeyPair();
+		wallet.address = csdb::Address::from_public_key(
+			csdb::internal::byte_array(wallet.keys.publicKey.data(), wallet.keys.publicKey.data() + wallet.keys.publicKey.size()));
+	}
+
+	signed_.reset(new BoundedQueue<csdb::Transaction>(section->get<size_t>("presigned", DEFAULT_PRESIGNED)));
+	sender_ = std::move(sender);
+	started_ = StageClock::now();
+
+	signer_ = std::thread(&LoadGenerator::signerRoutine, this, onSignerStart);
+
+	LOG_EVENT("Generating " << rate_ << " transactions per second from " << wallets << " wallets");
+}
+
+void LoadGenerator::signerRoutine(std::function<void()> onStart) {
+	if (onStart) onStart();
+
+	const csdb::Currency currency("CS");
+	Backoff backoff;
+	size_t next = 0;
+
+	while (!quit_) {
+		Wallet& source = wallets_[next];
+		const Wallet& target = wallets_[(next + 1) % wallets_.size()];
+		next = (next + 1) % wallets_.size();
+
+		csdb::Transaction trans;
+		trans.set_innerID(++source.innerID);
+		trans.set_source(source.address);
+		trans.set_target(target.address);
+		trans.set_currency(currency);
+		trans.set_amount(csdb::Amount(1));
+		trans.set_max_fee(csdb::Amount(0));
+		trans.set_counted_fee(csdb::Amount(0));
+		trans.set_balance(csdb::Amount(0));
+
+		const auto bytes = trans.to_byte_stream_for_sig();
+		cscrypto::Signature signature;
+		ed25519_sign(signature.data(), bytes.data(), bytes.size(),
+		             source.keys.publicKey.data(), source.keys.privateKey.data());
+		trans.set_signature(std::string((const char*)signature.data(), signature.size()));
+
+		while (!signed_->tryPush(std::move(trans)) && !quit_)
+			backoff.wait();
+		backoff.reset();
+	}
+}
+
+void LoadGenerator::poll() {
+	if (!enabled_) return;
+
+	// Open loop: the schedule is kept by the clock, not by the blocks
+	const auto now = StageClock::now();
+	const double elapsed = std::chrono::duration<double>(now - started_).count();
+	const uint64_t target = (uint64_t)std::floor(elapsed * rate_);
+	const uint64_t due = std::min(target - std::min(target, scheduled_), MAX_BURST);
+
+	for (uint64_t i = 0; i < due; ++i) {
+		csdb::Transaction trans;
+		if (!signed_->tryPop(trans)) {
+			starved_ += due - i;
+			break;
+		}
+
+		const auto key = trans.source().public_key();
+		Key pending(std::string(key.begin(), key.end()), trans.innerID());
+
+		pending_.emplace(pending, now);
+		sendOrder_.emplace_back(std::move(pending), now);
+
+		sender_(trans);
+		++sent_;
+	}
+
+	scheduled_ += due;
+	expire(now);
+}
+
+void LoadGenerator::expire(StageClock::time_point now) {
+	while (!sendOrder_.empty()) {
+		auto& oldest = sendOrder_.front();
+		auto it = pending_.find(oldest.first);
+
+		if (it != pending_.end() && it->second == oldest.second) {
+			if (now - oldest.second < timeout_) break;
+
+			pending_.erase(it);
+			++lost_;
+		}
+
+		sendOrder_.pop_front();
+	}
+}
+
+void LoadGenerator::onBlock(const csdb::Pool& pool) {
+	if (!enabled_ || pending_.empty()) return;
+
+	const auto now = StageClock::now();
+	for (size_t i = 0; i < pool.transactions_count(); ++i) {
+		const csdb::Transaction trans = pool.transaction(i);
+		const auto key = trans.source().public_key();
+		auto it = pending_.find(Key(std::string(key.begin(), key.end()), trans.innerID()));
+		if (it == pending_.end()) continue;
+
+		latenciesMs_.push_back((uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second).count());
+		pending_.erase(it);
+		++done_;
+	}
+}
+
+void LoadGenerator::report(std::ostream& os) {
+	os << "load: " << sent_ << " sent, " << done_ << " in blocks, " << pending_.size() << " pending, "
+	   << lost_ << " lost, " << starved_ << " starved";
+
+	if (latenciesMs_.empty()) return;
+
+	std::sort(latenciesMs_.begin(), latenciesMs_.end());
+	auto percentile = [this](size_t p) { return latenciesMs_[(latenciesMs_.size() - 1) * p / 100]; };
+
+	os << ", p50 " << percentile(50) << " ms, p90 " << percentile(90) << " ms, p99 " << percentile(99)
+	   << " ms, max " << latenciesMs_.back() << " ms";
+
+	latenciesMs_.clear();
+}
+
+} // namespace Credits
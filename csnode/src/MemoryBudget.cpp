@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <iostream>
+
+#include <net/Logger.hpp>
+
+#include "csnode/MemoryBudget.hpp"
+
+namespace Credits {
+
+const uint32_t DEFAULT_TARGET = 80;
+
+MemoryBudget::MemoryBudget() : target_(DEFAULT_TARGET) { }
+
+void MemoryBudget::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("memory");
+	if (!section) return;
+
+	budget_ = section->get<size_t>("budget", budget_);
+	target_ = std::min(section->get<uint32_t>("target", target_), 100u);
+}
+
+void MemoryBudget::addPart(const std::string& name, Priority priority, Usage usage, Shrink shrink) {
+	std::lock_guard<std::mutex> l(lock_);
+
+	auto place = std::upper_bound(parts_.begin(), parts_.end(), priority,
+	                              [](Priority p, const Part& part) { return p < part.priority; });
+	parts_.insert(place, Part{ name, priority, std::move(usage), std::move(shrink) });
+}
+
+void MemoryBudget::removePart(const std::string& name) {
+	std::lock_guard<std::mutex> l(lock_);
+
+	parts_.erase(std::remove_if(parts_.begin(), parts_.end(), [&name](const Part& part) { return part.name == name; }),
+	             parts_.end());
+}
+
+void MemoryBudget::enforce() {
+	if (!budget_) return;
+
+	std::lock_guard<std::mutex> l(lock_);
+
+	std::vector<size_t> usages;
+	size_t total = 0;
+	for (auto& part : parts_) {
+		usages.push_back(part.usage());
+		total += usages.back();
+	}
+
+	if (total <= budget_) return;
+
+	const size_t target = budget_ / 100 * target_;
+	size_t excess = total - target;
+
+	LOG_WARN("The caches take " << (total >> 10) << " KB of " << (budget_ >> 10) << " KB, shrinking");
+
+	for (size_t i = 0; i < parts_.size() && excess; ++i) {
+		Part& part = parts_[i];
+		if (!part.shrink || !usages[i]) continue;
+
+		part.shrink(usages[i] > excess ? usages[i] - excess : 0);
+
+		const size_t usage = part.usage();
+		if (usage >= usages[i]) continue;
+
+		const size_t freed = usages[i] - usage;
+		excess -= std::min(excess, freed);
+		freed_ += freed;
+		++shrinks_;
+	}
+
+	if (excess)
+		LOG_WARN("Couldn't shrink the caches to " << (target >> 10) << " KB, " << (excess >> 10) << " KB over");
+}
+
+void MemoryBudget::report(std::ostream& os) const {
+	std::lock_guard<std::mutex> l(lock_);
+
+	size_t total = 0;
+	std::string parts;
+	for (auto& part : parts_) {
+		const size_t usage = part.usage();
+		total += usage;
+		parts += (parts.empty() ? "" : ", ") + part.name + " " + std::to_string(usage >> 10) + " KB";
+	}
+
+	os << "memory: " << (total >> 10) << " KB";
+	if (budget_) os << " of " << (budget_ >> 10) << " KB";
+	os << " (" << parts << "), " << shrinks_ << " shrinks, " << (freed_ >> 10) << " KB freed";
+}
+
+} // namespace Credits
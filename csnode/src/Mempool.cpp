@@ -0,0 +1,165 @@
+#include <algorithm>
+
+#include <csdb/address.h>
+#include <csdb/internal/types.h>
+
+#include "csnode/Mempool.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_MAX_BYTES = 64 << 20;
+const uint32_t DEFAULT_MAX_ROUNDS = 10;
+
+// The indexes, besides the serialized bytes
+const size_t ENTRY_OVERHEAD = 256;
+
+Mempool::Mempool() :
+	maxBytes_(DEFAULT_MAX_BYTES),
+	maxRounds_(DEFAULT_MAX_ROUNDS) { }
+
+void Mempool::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("mempool");
+	if (!section) return;
+
+	maxBytes_ = section->get<size_t>("maxBytes", maxBytes_);
+	maxRounds_ = section->get<uint32_t>("maxRounds", maxRounds_);
+}
+
+Mempool::Key Mempool::getKey(const csdb::Transaction& trans) {
+	const auto source = trans.source().public_key();
+	return Key{ std::string(source.begin(), source.end()), trans.innerID() };
+}
+
+Mempool::Result Mempool::add(const csdb::Transaction& trans) {
+	if (!trans.is_valid()) return Invalid;
+
+	Key key = getKey(trans);
+	if (entries_.count(key)) {
+		++duplicates_;
+		return Duplicate;
+	}
+
+	csdb::internal::byte_counter counter;
+	trans.to_byte_stream(counter);
+
+	const size_t bytes = counter.size() + ENTRY_OVERHEAD;
+	const csdb::Amount fee = trans.max_fee();
+
+	// Makes room from the cheaper ones, if they free enough of it
+	if (bytes_ + bytes > maxBytes_) {
+		size_t freed = 0;
+		for (auto it = byFee_.rbegin(); it != byFee_.rend() && (*it)->fee < fee && bytes_ - freed + bytes > maxBytes_; ++it)
+			freed += (*it)->bytes;
+
+		if (bytes_ - freed + bytes > maxBytes_) return Underpriced;
+
+		while (bytes_ + bytes > maxBytes_) {
+			erase(*byFee_.rbegin());
+			++evicted_;
+		}
+	}
+
+	auto place = entries_.emplace(std::move(key), Entry{ trans, nullptr, fee, arrivals_++, round_, bytes }).first;
+	Entry* entry = &place->second;
+	entry->key = &place->first;
+
+	byFee_.insert(entry);
+
+	Chain& chain = chains_[entry->key->source];
+	if (!chain.empty() && chain.begin()->first > entry->key->innerID)
+		heads_.erase(chain.begin()->second);
+
+	chain.emplace(entry->key->innerID, entry);
+	if (chain.begin()->second == entry)
+		heads_.insert(entry);
+
+	bytes_ += bytes;
+	++added_;
+
+	return Added;
+}
+
+void Mempool::erase(Entry* entry) {
+	byFee_.erase(entry);
+
+	auto chain = chains_.find(entry->key->source);
+	const bool head = chain->second.begin()->second == entry;
+
+	chain->second.erase(entry->key->innerID);
+
+	if (head) {
+		heads_.erase(entry);
+		if (!chain->second.empty())
+			heads_.insert(chain->second.begin()->second);
+	}
+
+	if (chain->second.empty())
+		chains_.erase(chain);
+
+	bytes_ -= entry->bytes;
+	entries_.erase(entries_.find(*entry->key));
+}
+
+void Mempool::remove(const csdb::Transaction& trans) {
+	auto entry = entries_.find(getKey(trans));
+	if (entry != entries_.end())
+		erase(&entry->second);
+}
+
+void Mempool::remove(csdb::Pool& pool) {
+	if (entries_.empty()) return;
+
+	for (auto& trans : pool.transactions())
+		remove(trans);
+}
+
+std::vector<csdb::Transaction> Mempool::take(size_t maxCount, size_t maxBytes) {
+	std::vector<csdb::Transaction> result;
+	result.reserve(std::min(maxCount, entries_.size()));
+
+	// The sources whose next transaction does not fit are left out
+	std::vector<Entry*> skipped;
+	size_t bytes = 0;
+
+	while (result.size() < maxCount && !heads_.empty()) {
+		Entry* best = *heads_.begin();
+
+		if (bytes + best->bytes - ENTRY_OVERHEAD > maxBytes) {
+			heads_.erase(heads_.begin());
+			skipped.push_back(best);
+			continue;
+		}
+
+		bytes += best->bytes - ENTRY_OVERHEAD;
+		result.push_back(std::move(best->transaction));
+		erase(best);  // The next one of the source becomes its head
+	}
+
+	for (auto entry : skipped)
+		heads_.insert(entry);
+
+	taken_ += result.size();
+	return result;
+}
+
+void Mempool::onRoundStart(uint32_t round) {
+	round_ = round;
+	if (!maxRounds_ || round < maxRounds_) return;
+
+	// Dropped by the solver, or never got into a block: the source may send it again
+	for (auto it = entries_.begin(); it != entries_.end();) {
+		Entry* entry = &(it++)->second;
+		if (entry->round + maxRounds_ <= round) {
+			erase(entry);
+			++expired_;
+		}
+	}
+}
+
+void Mempool::report(std::ostream& os) const {
+	os << "mempool: " << entries_.size() << " transactions, " << (bytes_ >> 10) << " KB, "
+	   << added_ << " added, " << duplicates_ << " duplicates, " << evicted_ << " evicted, "
+	   << expired_ << " expired, " << taken_ << " taken";
+}
+
+} // namespace Credits
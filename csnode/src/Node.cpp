@@ -4,6 +4,8 @@
 #include <net/Logger.hpp>
 
 #include "csnode/Node.hpp"
+#include "csnode/PerfCounters.hpp"
+#include "csnode/ThreadTopology.hpp"
 
 #include <snappy.h>
 
@@ -14,32 +16,282 @@ const unsigned MAX_CONFIDANTS = 3;
 
 namespace Credits {
 
+static csconnector::Config
+makeApiConfig(SessionIO* net, IngestQueue& ingest)
+{
+  csconnector::Config config;
+  config.onClientThread = [net]() {
+    net->getThreadTopology().applyToCurrent(ThreadRole::ApiClient);
+  };
+  config.submitTransaction = [&ingest](const csdb::Transaction& trans) {
+    return ingest.submit(trans);
+  };
+
+  return config;
+}
+
+// The transactions are checked in place and built only when asked for
+static bool
+readTransactions(const char* data,
+                 const size_t size,
+                 std::vector<csdb::Transaction>* transactions)
+{
+  IPackStream stream;
+  stream.init(data, size);
+
+  csdb::TransactionView view;
+  while (stream.good() && !stream.end()) {
+    stream >> view;
+    if (stream.good() && transactions)
+      transactions->push_back(view.to_transaction());
+  }
+
+  return stream.good();
+}
+
+static bool
+readPool(const char* data, const size_t size, csdb::Pool* pool)
+{
+  IPackStream stream;
+  stream.init(data, size);
+
+  csdb::PoolView view;
+  stream >> view;
+
+  if (!stream.good() || !stream.end())
+    return false;
+
+  if (pool)
+    *pool = view.to_pool();
+
+  return true;
+}
+
+static bool
+readBlock(const char* data, const size_t size, csdb::Pool* pool)
+{
+#ifdef NET_COMPRESSION
+  // Kept by every decoding thread, so a block of the usual size takes no allocation
+  thread_local std::string decompressed;
+  if (!::snappy::Uncompress(data, size, &decompressed))
+    return false;
+
+  return readPool(decompressed.data(), decompressed.size(), pool);
+#else
+  return readPool(data, size, pool);
+#endif
+}
+
+// Salt, checksum and short ids, then the candidate without its transactions
+static bool
+readCompactCandidate(const char* data,
+                     const size_t size,
+                     CompactCandidate& compact)
+{
+  IPackStream stream;
+  stream.init(data, size);
+
+  uint32_t count = 0;
+  stream >> compact.salt >> compact.checksum >> count;
+  if (!stream.good() || count > size / SHORT_ID_BYTES)
+    return false;
+
+  compact.ids.resize(count);
+  for (auto& id : compact.ids) {
+    uint32_t low = 0;
+    uint16_t high = 0;
+    stream >> low >> high;
+    id = (ShortTransactionId(high) << 32) | low;
+  }
+
+  csdb::PoolView view;
+  stream >> view;
+
+  if (!stream.good() || !stream.end())
+    return false;
+
+  compact.header = view.to_pool();
+  return true;
+}
+
 Node::Node(const NodeId& myId, const PublicKey& pk, SessionIO* net)
   : myId_(myId)
   , myPublicKey_(pk)
-  , bc_(PATH_TO_DB)
+  , bc_(PATH_TO_DB, net->getConfig())
   , ostream_(net)
   , net_(net)
-  , solver_(
-      Credits::SolverFactory().createSolver(Credits::solver_type::real, this))
+  , solver_(net->isObserver() ? nullptr
+                               : Credits::SolverFactory().createSolver(
+                                   Credits::solver_type::real, this))
   , stats(bc_)
-  , api(bc_, solver_.get())
+  , ingest_(net->getConfig())
+  , api(bc_, solver_.get(), makeApiConfig(net, ingest_))
+  , coalescer_([this](std::vector<csdb::Transaction>&& transactions) {
+    sendTransaction(std::move(transactions));
+  })
 {
   good_ = init();
 }
 
+void
+Node::processPipeline()
+{
+  pipeline_.apply();
+  load_.poll();
+  coalescer_.poll();
+
+  // The observers have no solver, they relay the API ones to the main node
+  ingest_.drain([this](csdb::Transaction&& trans) {
+    if (net_->isObserver())
+      sendTransaction(trans);
+    else
+      solver_->send_wallet_transaction(trans);
+  });
+}
+
+bool
+Node::verifyTransactions(const std::vector<csdb::Transaction>& transactions)
+{
+  if (!verifier_.isEnabled() || verifier_.verify(transactions))
+    return true;
+
+  LOG_WARN("Bad transaction signature, dropping " << transactions.size()
+                                                  << " transactions");
+  return false;
+}
+
+bool
+Node::verifyBlock(csdb::Pool& pool)
+{
+  if (!verifier_.isEnabled() || verifier_.verify(pool))
+    return true;
+
+  LOG_WARN("Bad signature in block " << pool.sequence());
+  return false;
+}
+
 bool
 Node::init()
 {
   if (!bc_.isGood())
     return false;
 
-  // Create solver
+  startup_.reach(StartupPhase::StorageReady);
+
+  // The ring is greeted again right away, before the signal server answers.
+  // The saved round is not restored: the signal server may have restarted
+  // since, its tables are taken whatever round they start from
+  Snapshot& snapshot = bc_.getSnapshot();
+  snapshot.restore("node", [this](SnapshotReader& in) {
+    uint32_t round = 0;
+    uint32_t count = 0;
+    in >> round >> count;
+
+    std::vector<uint32_t> addresses;
+    for (uint32_t i = 0; i < count && in.good(); ++i) {
+      addresses.emplace_back();
+      in >> addresses.back();
+    }
+
+    if (!in.good() || !in.end())
+      return false;
 
-  if (!solver_)
-    return false;
-  solver_->initApi();
-  solver_->addInitialBalance();
+    LOG_NOTICE("Restored the ring of round " << round);
+    for (auto address : addresses)
+      net_->addToRingBuffer(ip::make_address_v4(address));
+
+    return true;
+  });
+
+  snapshot.addPart("node", [this](SnapshotWriter& out) {
+    const auto addresses = net_->getRingAddresses();
+
+    out << roundNum_ << (uint32_t)addresses.size();
+    for (auto& address : addresses)
+      out << (uint32_t)address.to_v4().to_uint();
+  });
+
+  // Create solver, the observers follow the chain without one
+
+  if (!net_->isObserver()) {
+    if (!solver_)
+      return false;
+    solver_->initApi();
+    solver_->addInitialBalance();
+  }
+
+  const auto& topology = net_->getThreadTopology();
+  topology.apply(ThreadRole::Storage, bc_.getStorageThread());
+  topology.apply(ThreadRole::Stats, stats.getThreadHandle());
+  topology.apply(ThreadRole::Api, api.getThreadHandle());
+  topology.apply(ThreadRole::Storage, bc_.getStorageStage().getThreadHandle());
+  topology.apply(ThreadRole::Decode, assembler_.getThreadHandle());
+
+  // The chain is read in the background, the node takes its part in the
+  // rounds meanwhile
+  startup_.reach(StartupPhase::ApiReady);
+  startup_.addWarmUp("stats", [this]() { stats.waitFirstUpdate(); });
+  startup_.addWarmUp("api", [this]() { api.warmUp(); });
+  startup_.startWarmUps([this]() {
+    net_->getThreadTopology().applyToCurrent(ThreadRole::Stats);
+  });
+
+  pipeline_.start(net_->getConfig(), [this]() {
+    net_->getThreadTopology().applyToCurrent(ThreadRole::Decode);
+  });
+  pipeline_.addReported("storage", &bc_.getStorageStage());
+
+  bc_.getBalanceCache().start([this]() {
+    net_->getThreadTopology().applyToCurrent(ThreadRole::Storage);
+  });
+  pipeline_.addReported(
+    [this](std::ostream& os) { bc_.getBalanceCache().report(os); });
+
+  coalescer_.load(net_->getConfig());
+  timeline_.load(net_->getConfig());
+  pipeline_.addReported(
+    [this](std::ostream& os) { coalescer_.report(os); });
+
+  verifier_.start(net_->getConfig(), [this]() {
+    net_->getThreadTopology().applyToCurrent(ThreadRole::Decode);
+  });
+  if (verifier_.isEnabled())
+    pipeline_.addReported(
+      [this](std::ostream& os) { verifier_.report(os); });
+
+  relay_.load(net_->getConfig());
+  if (relay_.isEnabled())
+    pipeline_.addReported([this](std::ostream& os) { relay_.report(os); });
+
+  assembler_.load(net_->getConfig());
+  if (assembler_.isEnabled())
+    pipeline_.addReported([this](std::ostream& os) { assembler_.report(os); });
+
+  mempool_.load(net_->getConfig());
+  pipeline_.addReported([this](std::ostream& os) { mempool_.report(os); });
+
+  pipeline_.addReported([this](std::ostream& os) { ingest_.report(os); });
+
+  if (PerfCounters::isEnabled())
+    pipeline_.addReported([](std::ostream& os) { PerfCounters::report(os); });
+
+  pipeline_.addReported(
+    [this](std::ostream& os) { bc_.getMemoryBudget().report(os); });
+
+  // The main node takes its own as if they came from the others
+  load_.start(
+    net_->getConfig(),
+    [this](const csdb::Transaction& trans) {
+      if (myLevel_ != NodeLevel::Main)
+        sendTransaction(trans);
+      else if (mempool_.add(trans) == Mempool::Added)
+        solver_->gotTransaction(csdb::Transaction(trans));
+    },
+    [this]() {
+      net_->getThreadTopology().applyToCurrent(ThreadRole::Decode);
+    });
+  if (load_.isEnabled())
+    pipeline_.addReported([this](std::ostream& os) { load_.report(os); });
 
   return true;
 }
@@ -48,6 +300,15 @@ Node::init()
 
 void
 Node::getRoundTable(const char* data, const size_t size)
+{
+  pipeline_.inOrder(data, size, [this](const char* data, const size_t size) {
+    processRoundTable(data, size);
+    return Pipeline::Action();
+  });
+}
+
+void
+Node::processRoundTable(const char* data, const size_t size)
 {
   istream_.init(data, size);
 
@@ -83,22 +344,45 @@ Node::sendRoundTable()
 void
 Node::getTransaction(const char* data, const size_t size)
 {
-  if (myLevel_ != NodeLevel::Main && myLevel_ != NodeLevel::Writer) {
-    return;
-  }
-
-  istream_.init(data, size);
-
-  while (istream_.good() && !istream_.end()) {
-    csdb::Transaction trans;
-    istream_ >> trans;
-    solver_->gotTransaction(std::move(trans));
-  }
-
-  if (!istream_.good()) {
-    LOG_WARN("Bad transaction packet format");
-    return;
-  }
+  pipeline_.decode(data, size, [this](const char* data, const size_t size) {
+    // Only the nodes taking the transactions build them, the level is checked
+    // again when applying. Confidants keep them for the compact candidates
+    const NodeLevel level = myLevel_;
+    const bool seen = level == NodeLevel::Confidant && relay_.isEnabled();
+    const bool built =
+      seen || level == NodeLevel::Main || level == NodeLevel::Writer;
+
+    std::vector<csdb::Transaction> transactions;
+    const bool good =
+      readTransactions(data, size, built ? &transactions : nullptr);
+    const bool verified = !built || verifyTransactions(transactions);
+
+    if (seen && verified)
+      relay_.addSeen(transactions);
+
+    return Pipeline::Action(
+      [this, data, size, transactions = std::move(transactions), built, good, verified]() mutable {
+        if (myLevel_ != NodeLevel::Main && myLevel_ != NodeLevel::Writer) {
+          return;
+        }
+
+        if (!built) {  // The level has changed since
+          readTransactions(data, size, &transactions);
+          if (!verifyTransactions(transactions))
+            return;
+        }
+        else if (!verified)
+          return;
+
+        // The repeated ones are already with the solver
+        for (auto& trans : transactions)
+          if (mempool_.add(trans) == Mempool::Added)
+            solver_->gotTransaction(std::move(trans));
+
+        if (!good)
+          LOG_WARN("Bad transaction packet format");
+      });
+  });
 }
 
 void
@@ -111,15 +395,7 @@ Node::sendTransaction(const csdb::Transaction& trans)
   }
 #endif
 
-  ostream_.init();
-  ostream_ << trans;
-
-  LOG_EVENT("Sending transaction to " << mainNode_);
-  net_->addTaskDirect(std::move(ostream_.get()),
-                      CommandList::GetTransaction,
-                      SubCommandList::Empty,
-                      ostream_.lastSize(),
-                      mainNode_);
+  coalescer_.add(trans);
 }
 
 void
@@ -137,6 +413,13 @@ Node::sendTransaction(std::vector<csdb::Transaction>&& transactions)
   for (auto& tr : transactions)
     ostream_ << tr;
 
+  // The confidants rebuild the compact candidates from them
+  if (relay_.isEnabled()) {
+    sendByConfidants(CommandList::GetTransaction, SubCommandList::Empty);
+    if (myLevel_ == NodeLevel::Confidant)
+      relay_.addSeen(transactions);
+  }
+
   LOG_EVENT("Sending transactions to " << mainNode_);
   net_->addTaskDirect(std::move(ostream_.get()),
                       CommandList::GetTransaction,
@@ -148,24 +431,30 @@ Node::sendTransaction(std::vector<csdb::Transaction>&& transactions)
 void
 Node::getFirstTransaction(const char* data, const size_t size)
 {
-  if (myLevel_ != NodeLevel::Confidant) {
-    return;
-  }
-
-  istream_.init(data, size);
+  pipeline_.decode(data, size, [this](const char* data, const size_t size) {
+    IPackStream stream;
+    stream.init(data, size);
 
-  csdb::Transaction trans;
-  istream_ >> trans;
+    csdb::Transaction trans;
+    stream >> trans;
 
-  if (!istream_.good() || !istream_.end()) {
-    LOG_WARN("Bad transaction packet format");
-    return;
-  }
+    return Pipeline::Action(
+      [this, trans, good = stream.good() && stream.end()]() mutable {
+        if (myLevel_ != NodeLevel::Confidant) {
+          return;
+        }
 
-  LOG_EVENT("Got first transaction, initializing consensus...");
+        if (!good) {
+          LOG_WARN("Bad transaction packet format");
+          return;
+        }
 
+        LOG_EVENT("Got first transaction, initializing consensus...");
+        timeline_.mark(RoundPhase::FirstTransaction);
 
-  solver_->gotTransactionList(std::move(trans));
+        solver_->gotTransactionList(std::move(trans));
+      });
+  });
 }
 
 void
@@ -185,21 +474,215 @@ Node::sendFirstTransaction(const csdb::Transaction& trans)
 void
 Node::getTransactionsList(const char* data, const size_t size)
 {
-  if (myLevel_ != NodeLevel::Confidant && myLevel_ != NodeLevel::Writer) {
-    return;
-  }
+  pipeline_.decode(data, size, [this](const char* data, const size_t size) {
+    const NodeLevel level = myLevel_;
+    const bool built =
+      level == NodeLevel::Confidant || level == NodeLevel::Writer;
+
+    csdb::Pool pool;
+    const bool good = readPool(data, size, built ? &pool : nullptr);
+    const bool verified =
+      !(built && good) || verifyTransactions(pool.transactions());
+
+    return Pipeline::Action(
+      [this, data, size, pool, built, good, verified]() mutable {
+        if (myLevel_ != NodeLevel::Confidant &&
+            myLevel_ != NodeLevel::Writer) {
+          return;
+        }
+
+        if (!good) {
+          LOG_WARN("Bad transactions list packet format");
+          return;
+        }
+
+        if (!built) {
+          readPool(data, size, &pool);
+          if (!verifyTransactions(pool.transactions()))
+            return;
+        }
+        else if (!verified)
+          return;
+
+        gotCandidate(std::move(pool));
+      });
+  });
+}
+
+void
+Node::getCompactTransactionsList(const char* data,
+                                 const size_t size,
+                                 const NodeId& sender)
+{
+  pipeline_.decode(data, size, [this, sender](const char* data, const size_t size) {
+    CompactCandidate compact;
+    const bool good = readCompactCandidate(data, size, compact);
+
+    // Matched against the transactions seen and, if all of them are there, built
+    PartialCandidate partial;
+    csdb::Pool pool;
+    bool built = false;
+
+    if (good) {
+      partial = relay_.rebuild(std::move(compact));
+      built = partial.missing.empty() && partial.build(pool);
+    }
+
+    return Pipeline::Action(
+      [this, sender, partial = std::move(partial), pool, good, built]() mutable {
+        if (myLevel_ != NodeLevel::Confidant &&
+            myLevel_ != NodeLevel::Writer) {
+          return;
+        }
+
+        if (!good) {
+          LOG_WARN("Bad compact transactions list packet format");
+          return;
+        }
+
+        if (built) {
+          gotCandidate(std::move(pool));
+          return;
+        }
+
+        if (partial.missing.empty())  // A short id matched a wrong transaction
+          partial.missAll();
+
+        LOG_EVENT("Missing " << partial.missing.size() << " of "
+                             << partial.transactions.size()
+                             << " candidate transactions");
+
+        relay_.setPending(std::move(partial));
+        requestCandidateTransactions(sender);
+      });
+  });
+}
+
+void
+Node::requestCandidateTransactions(const NodeId& target)
+{
+  const PartialCandidate& pending = relay_.getPending();
+
+  ostream_.init();
+  ostream_ << pending.compact.salt;
 
+  for (auto index : pending.missing)
+    ostream_ << index;
+
+  net_->addTaskDirect(std::move(ostream_.get()),
+                      CommandList::GetCandidateRequest,
+                      SubCommandList::Empty,
+                      ostream_.lastSize(),
+                      target);
+}
+
+void
+Node::getCandidateRequest(const char* data,
+                          const size_t size,
+                          const NodeId& sender)
+{
+  pipeline_.inOrder(data, size, [this, sender](const char* data, const size_t size) {
+    processCandidateRequest(data, size, sender);
+    return Pipeline::Action();
+  });
+}
+
+void
+Node::processCandidateRequest(const char* data,
+                              const size_t size,
+                              const NodeId& sender)
+{
   istream_.init(data, size);
 
-  csdb::Pool pool;
-  istream_ >> pool;
+  uint64_t salt = 0;
+  istream_ >> salt;
 
-  if (!istream_.good() || !istream_.end()) {
-    LOG_WARN("Bad transactions list packet format");
+  std::vector<uint32_t> indices;
+  while (istream_) {
+    indices.push_back(0);
+    istream_ >> indices.back();
+  }
+
+  if (!istream_.good()) {
+    LOG_WARN("Bad candidate request format");
     return;
   }
 
+  std::vector<csdb::Transaction> transactions;
+  if (!relay_.getTransactions(salt, indices, transactions)) {
+    LOG_NOTICE("Candidate request from " << sender
+                                         << " for an unknown candidate");
+    return;
+  }
+
+  ostream_.init();
+  ostream_ << salt;
+
+  for (auto& trans : transactions)
+    ostream_ << trans;
+
+  net_->sendBulkDirect(std::move(ostream_.get()),
+                       CommandList::GetCandidateTransactions,
+                       SubCommandList::Empty,
+                       ostream_.lastSize(),
+                       sender);
+}
+
+void
+Node::getCandidateTransactions(const char* data, const size_t size)
+{
+  pipeline_.decode(data, size, [this](const char* data, const size_t size) {
+    uint64_t salt = 0;
+    std::vector<csdb::Transaction> transactions;
+
+    const bool good =
+      size >= sizeof(salt) &&
+      readTransactions(data + sizeof(salt), size - sizeof(salt), &transactions);
+    const bool verified = good && verifyTransactions(transactions);
+
+    if (good)
+      memcpy(&salt, data, sizeof(salt));
+
+    return Pipeline::Action(
+      [this, salt, transactions = std::move(transactions), good, verified]() mutable {
+        if (!good) {
+          LOG_WARN("Bad candidate transactions packet format");
+          return;
+        }
+
+        // Built already, or a candidate of another round
+        if (!relay_.isPending(salt))
+          return;
+
+        PartialCandidate& pending = relay_.getPending();
+
+        csdb::Pool pool;
+        const bool built = verified &&
+                           pending.fill(std::move(transactions)) &&
+                           pending.build(pool);
+
+        relay_.dropPending();
+
+        if (!built) {
+          LOG_WARN("Cannot rebuild the block candidate");
+          return;
+        }
+
+        if (myLevel_ != NodeLevel::Confidant &&
+            myLevel_ != NodeLevel::Writer) {
+          return;
+        }
+
+        gotCandidate(std::move(pool));
+      });
+  });
+}
+
+void
+Node::gotCandidate(csdb::Pool&& pool)
+{
   LOG_EVENT("Got full transactions list of " << pool.transactions_count());
+  timeline_.mark(RoundPhase::BlockCandidate);
   solver_->gotBlockCandidate(std::move(pool));
 }
 
@@ -212,17 +695,46 @@ Node::sendTransactionList(const csdb::Pool& pool, const NodeId& target)
   }
 
   ostream_.init();
+
+  if (relay_.isEnabled()) {
+    const CompactCandidate compact = relay_.makeCandidate(pool);
+
+    ostream_ << compact.salt << compact.checksum
+             << static_cast<uint32_t>(compact.ids.size());
+
+    for (auto id : compact.ids)
+      ostream_ << static_cast<uint32_t>(id) << static_cast<uint16_t>(id >> 32);
+
+    ostream_ << compact.header;
+
+    net_->sendBulkDirect(std::move(ostream_.get()),
+                         CommandList::GetCompactCandidate,
+                         SubCommandList::Empty,
+                         ostream_.lastSize(),
+                         target);
+    return;
+  }
+
   ostream_ << pool;
 
-  net_->addTaskDirect(std::move(ostream_.get()),
-                      CommandList::GetBlockCandidate,
-                      SubCommandList::Empty,
-                      ostream_.lastSize(),
-                      target);
+  net_->sendBulkDirect(std::move(ostream_.get()),
+                       CommandList::GetBlockCandidate,
+                       SubCommandList::Empty,
+                       ostream_.lastSize(),
+                       target);
 }
 
 void
 Node::getVector(const char* data, const size_t size, const NodeId& sender)
+{
+  pipeline_.inOrder(data, size, [this, sender](const char* data, const size_t size) {
+    processVector(data, size, sender);
+    return Pipeline::Action();
+  });
+}
+
+void
+Node::processVector(const char* data, const size_t size, const NodeId& sender)
 {
   if (myLevel_ != NodeLevel::Confidant) {
     return;
@@ -239,6 +751,7 @@ Node::getVector(const char* data, const size_t size, const NodeId& sender)
   }
 
   LOG_EVENT("Got vector from " << sender);
+  timeline_.mark(RoundPhase::Vector, sender);
   solver_->gotVector(std::move(vec), sender);
 }
 
@@ -261,6 +774,15 @@ Node::sendVector(const Vector& vector)
 
 void
 Node::getMatrix(const char* data, const size_t size, const NodeId& sender)
+{
+  pipeline_.inOrder(data, size, [this, sender](const char* data, const size_t size) {
+    processMatrix(data, size, sender);
+    return Pipeline::Action();
+  });
+}
+
+void
+Node::processMatrix(const char* data, const size_t size, const NodeId& sender)
 {
   if (myLevel_ != NodeLevel::Confidant) {
     return;
@@ -277,6 +799,7 @@ Node::getMatrix(const char* data, const size_t size, const NodeId& sender)
   }
 
   LOG_EVENT("Got matrix from " << sender);
+  timeline_.mark(RoundPhase::Matrix, sender);
 
   std::size_t taskIdx = 0;
   for (auto& conf : confidantNodes_) {
@@ -305,33 +828,69 @@ Node::sendMatrix(const Matrix& matrix)
 }
 
 void
-Node::getBlock(const char* data, const size_t size, const NodeId& sender)
+Node::getBlock(const char* data,
+               const size_t size,
+               const NodeId& sender,
+               const Hash& key)
 {
-  if (myLevel_ == NodeLevel::Writer) {
-    return;
-  }
-
-  myLevel_ = NodeLevel::Normal;
+  pipeline_.decode(data, size, [this, sender, key](const char* data, const size_t size) {
+    // Writers skip the blocks
+    const bool built = myLevel_ != NodeLevel::Writer;
+
+    // Mostly read already, if it came by fragments
+    csdb::Pool pool;
+    const bool good = (built && assembler_.take(key, pool)) ||
+                      readBlock(data, size, built ? &pool : nullptr);
+    const bool verified = !(built && good) || verifyBlock(pool);
+
+    return Pipeline::Action(
+      [this, data, size, pool, sender, built, good, verified]() mutable {
+        if (myLevel_ == NodeLevel::Writer) {
+          return;
+        }
+
+        myLevel_ = NodeLevel::Normal;
+
+        if (!good) {
+          LOG_WARN("Bad block packet format");
+          return;
+        }
+
+        if (!built) {
+          readBlock(data, size, &pool);
+          if (!verifyBlock(pool))
+            return;
+        }
+        else if (!verified)
+          return;
+
+        LOG_EVENT("Got block of " << pool.transactions_count());
+        timeline_.mark(RoundPhase::BlockReceived, sender);
+        load_.onBlock(pool);
+
+        // Observers follow the chain without the solver
+        if (net_->isObserver()) {
+          bc_.writeLastBlock(std::move(pool));
+          return;
+        }
+
+        mempool_.remove(pool);
+        solver_->gotBlock(std::move(pool), sender);
+      });
+  });
+}
 
-#ifdef NET_COMPRESSION
-  std::string decompressed;
-  ::snappy::Uncompress(data, size, &decompressed);
-  istream_.init(decompressed.data(), decompressed.size());
-#else
-  istream_.init(data, size);
+void
+Node::getBlockFragment(const Hash& key,
+                       const size_t index,
+                       const size_t count,
+                       const char* data,
+                       const size_t size)
+{
+#ifndef NET_COMPRESSION  // Compressed blocks are read whole
+  if (assembler_.isEnabled() && myLevel_ != NodeLevel::Writer)
+    assembler_.addFragment(key, index, count, data, size);
 #endif
-
-  csdb::Pool pool;
-  istream_ >> pool;
-
-  if (!istream_.good() || !istream_.end()) {
-    LOG_WARN("Bad block packet format");
-    return;
-  }
-
-  LOG_EVENT("Got block of " << pool.transactions_count());
-
-  solver_->gotBlock(std::move(pool), sender);
 }
 
 void
@@ -354,12 +913,23 @@ Node::sendBlock(const csdb::Pool& pool)
 #endif
 
   LOG_EVENT("Sending block of " << pool.transactions_count());
-  net_->addTaskBroadcast(
+  timeline_.mark(RoundPhase::BlockSent);
+  load_.onBlock(pool);
+  net_->sendBulkBroadcast(
     std::move(ostream_.get()), SubCommandList::GetBlock, ostream_.lastSize());
 }
 
 void
 Node::getHash(const char* data, const size_t size, const NodeId& sender)
+{
+  pipeline_.inOrder(data, size, [this, sender](const char* data, const size_t size) {
+    processHash(data, size, sender);
+    return Pipeline::Action();
+  });
+}
+
+void
+Node::processHash(const char* data, const size_t size, const NodeId& sender)
 {
   if (myLevel_ != NodeLevel::Writer) {
     return;
@@ -376,6 +946,7 @@ Node::getHash(const char* data, const size_t size, const NodeId& sender)
   }
 
   LOG_EVENT("Got hash from " << sender);
+  timeline_.mark(RoundPhase::Hash, sender);
   solver_->gotHash(std::move(hash), sender);
 }
 
@@ -387,6 +958,10 @@ Node::sendHash(const Hash& hash, const NodeId& target)
     return;
   }
 
+  // Not becoming a candidate for the next rounds
+  if (net_->isObserver())
+    return;
+
   ostream_.init();
   ostream_ << hash;
 
@@ -399,6 +974,15 @@ Node::sendHash(const Hash& hash, const NodeId& target)
 
 void
 Node::getInitRing(const char* data, const size_t size)
+{
+  pipeline_.inOrder(data, size, [this](const char* data, const size_t size) {
+    processInitRing(data, size);
+    return Pipeline::Action();
+  });
+}
+
+void
+Node::processInitRing(const char* data, const size_t size)
 {
   istream_.init(data, size);
 
@@ -416,6 +1000,7 @@ Node::getInitRing(const char* data, const size_t size)
     return;
   }
 
+  startup_.reach(StartupPhase::NetworkReady);
   onRoundStart();
   net_->removeAllTasks();
 }
@@ -427,11 +1012,17 @@ Node::becomeWriter()
     LOG_WARN("Logically impossible to become a writer right now");
 
   myLevel_ = NodeLevel::Writer;
+  timeline_.mark(RoundPhase::Writer);
 }
 
 void
 Node::onRoundStart()
 {
+  // To the new main node
+  coalescer_.flush(TransactionCoalescer::Round);
+  relay_.onRoundStart();
+  mempool_.onRoundStart(roundNum_);
+
   if (mainNode_ == myId_)
     myLevel_ = NodeLevel::Main;
   else {
@@ -448,7 +1039,19 @@ Node::onRoundStart()
       myLevel_ = NodeLevel::Normal;
   }
 
-  solver_->nextRound();
+  if (net_->isObserver() && myLevel_ != NodeLevel::Normal) {
+    LOG_WARN("Observer node chosen for round " << roundNum_ << ", staying aside");
+    myLevel_ = NodeLevel::Normal;
+  }
+
+  timeline_.startRound(roundNum_, myLevel_);
+  if (!net_->isObserver())
+    solver_->nextRound();
+
+  if (bc_.getSnapshot().isDue(roundNum_))
+    bc_.saveSnapshot();
+
+  bc_.getMemoryBudget().enforce();
 
   std::cerr << "Round " << roundNum_ << " started. Mynode_type:=" << myLevel_
             << ", General: " << mainNode_ << ", Confidants: ";
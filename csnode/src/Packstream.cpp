@@ -33,6 +33,26 @@ IPackStream& IPackStream::operator>>(csdb::Pool& pool) {
     return *this;
 }
 
+template <>
+IPackStream& IPackStream::operator>>(csdb::TransactionView& view) {
+    if (view.parse(ptr_, end_ - ptr_))
+        ptr_ += view.binary_size();
+    else
+        good_ = false;
+
+    return *this;
+}
+
+template <>
+IPackStream& IPackStream::operator>>(csdb::PoolView& view) {
+    if (view.parse(ptr_, end_ - ptr_))
+        ptr_ += view.binary_size();
+    else
+        good_ = false;
+
+    return *this;
+}
+
 template <>
 OPackStream& OPackStream::operator<<(const Credits::NodeId& d) {
     *this << (uint32_t)d.to_v4().to_uint();
@@ -47,15 +67,12 @@ OPackStream& OPackStream::operator<<(const std::string& str) {
 
 template <>
 OPackStream& OPackStream::operator<<(const csdb::Transaction& trans) {
-    auto byteArray = trans.to_byte_stream();
-    insertBytes((char*)byteArray.data(), byteArray.size());
+    trans.to_byte_stream(*this);
     return *this;
 }
 
 template <>
 OPackStream& OPackStream::operator<<(const csdb::Pool& pool) {
-    size_t bSize;
-    char* data = const_cast<csdb::Pool&>(pool).to_byte_stream(bSize);
-    insertBytes((char*)data, bSize);
+    pool.to_byte_stream(*this);
     return *this;
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <iomanip>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#include <net/Logger.hpp>
+
+#include "csnode/PerfCounters.hpp"
+
+namespace Credits {
+
+const uint32_t DEFAULT_SAMPLE = 16;
+
+static const char* STAGE_NAMES[] = { "receive", "reassemble", "decode", "verify", "solver", "storage", "api" };
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == (size_t)PerfStage::Count, "Every stage needs a name");
+
+struct StageTotals {
+	std::atomic<uint64_t> counters[PerfCounters::CounterCount];
+	std::atomic<uint64_t> sections;
+};
+
+static std::atomic_bool enabled{ false };
+static uint32_t sampleEvery = DEFAULT_SAMPLE;
+static StageTotals totals[(size_t)PerfStage::Count];
+
+#ifdef __linux__
+static const uint64_t EVENTS[] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+static_assert(sizeof(EVENTS) / sizeof(EVENTS[0]) == PerfCounters::CounterCount, "Every counter needs an event");
+
+// The counters of the calling thread, read together as a group
+class ThreadCounters {
+public:
+	~ThreadCounters() {
+		for (int fd : fds_)
+			if (fd >= 0) close(fd);
+	}
+
+	bool read(uint64_t* values) {
+		if (!tried_) open();
+		if (fds_[0] < 0) return false;
+
+		struct {
+			uint64_t count;
+			uint64_t values[PerfCounters::CounterCount];
+		} group;
+
+		if (::read(fds_[0], &group, sizeof(group)) != sizeof(group)) return false;
+
+		memcpy(values, group.values, sizeof(group.values));
+		return true;
+	}
+
+	// Every stage on its own, the nested ones would be skipped in step otherwise
+	bool isSampled(PerfStage stage) { return sections_[(size_t)stage]++ % sampleEvery == 0; }
+
+private:
+	void open() {
+		tried_ = true;
+
+		for (size_t i = 0; i < PerfCounters::CounterCount; ++i) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = EVENTS[i];
+			attr.read_format = PERF_FORMAT_GROUP;
+			attr.exclude_kernel = 1;  // Allowed unprivileged
+			attr.exclude_hv = 1;
+
+			fds_[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, fds_[0], 0);
+			if (fds_[i] < 0) {
+				LOG_WARN("Cannot open the hardware counters: " << strerror(errno));
+
+				for (size_t j = 0; j < i; ++j) {
+					close(fds_[j]);
+					fds_[j] = -1;
+				}
+
+				return;
+			}
+		}
+	}
+
+	int fds_[PerfCounters::CounterCount] = { -1, -1, -1, -1 };
+	bool tried_ = false;
+	uint32_t sections_[(size_t)PerfStage::Count] = {};
+};
+
+static thread_local ThreadCounters threadCounters;
+#endif
+
+bool PerfCounters::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("perf");
+	if (!section || !section->get<bool>("enabled", false)) return false;
+
+	sampleEvery = std::max<uint32_t>(section->get<uint32_t>("sample", DEFAULT_SAMPLE), 1);
+
+#ifdef __linux__
+	// The other threads open theirs alike
+	uint64_t values[CounterCount];
+	if (!threadCounters.read(values)) {
+		LOG_WARN("The stages are not profiled, no hardware counters on this host");
+		return false;
+	}
+
+	enabled = true;
+	return true;
+#else
+	LOG_WARN("The stages are profiled on Linux only");
+	return false;
+#endif
+}
+
+bool PerfCounters::isEnabled() {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void PerfCounters::report(std::ostream& os) {
+	os << "perf:";
+
+	bool first = true;
+	for (size_t i = 0; i < (size_t)PerfStage::Count; ++i) {
+		StageTotals& stage = totals[i];
+
+		const uint64_t sections = stage.sections.exchange(0);
+		uint64_t counters[CounterCount];
+		for (size_t c = 0; c < CounterCount; ++c)
+			counters[c] = stage.counters[c].exchange(0);
+
+		if (!sections || !counters[Instructions]) continue;
+
+		// Misses per thousand instructions
+		const double kiloInstructions = counters[Instructions] / 1000.0;
+
+		os << (first ? " " : ", ") << STAGE_NAMES[i] << " " << sections << " sampled, "
+		   << std::fixed << std::setprecision(2)
+		   << counters[Cycles] / 1000.0 / sections << " kcycles each, IPC "
+		   << (counters[Cycles] ? (double)counters[Instructions] / counters[Cycles] : 0.0)
+		   << ", cache MPKI " << counters[CacheMisses] / kiloInstructions
+		   << ", branch MPKI " << counters[BranchMisses] / kiloInstructions;
+
+		first = false;
+	}
+
+	if (first) os << " nothing sampled";
+}
+
+const char* PerfCounters::getStageName(PerfStage stage) {
+	return STAGE_NAMES[(size_t)stage];
+}
+
+PerfScope::PerfScope(PerfStage stage) : stage_(stage) {
+#ifdef __linux__
+	if (!PerfCounters::isEnabled() || !threadCounters.isSampled(stage)) return;
+	counted_ = threadCounters.read(started_);
+#endif
+}
+
+PerfScope::~PerfScope() {
+#ifdef __linux__
+	if (!counted_) return;
+
+	uint64_t finished[PerfCounters::CounterCount];
+	if (!threadCounters.read(finished)) return;
+
+	StageTotals& stage = totals[(size_t)stage_];
+	for (size_t i = 0; i < PerfCounters::CounterCount; ++i)
+		stage.counters[i].fetch_add(finished[i] - started_[i], std::memory_order_relaxed);
+
+	stage.sections.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+} // namespace Credits
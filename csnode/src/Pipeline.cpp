@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <iostream>
+
+#include "csnode/PerfCounters.hpp"
+#include "csnode/Pipeline.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_DECODE_THREADS = 2;
+const size_t DEFAULT_QUEUE_SIZE = 1024;
+const size_t DEFAULT_MAX_PARKED = 4096;
+
+// Buffers of the bigger messages are not kept for reuse
+const size_t MAX_KEPT_BUFFER = 1 << 20;
+
+static uint64_t toUs(StageClock::duration d) {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+void StageStats::add(StageClock::time_point queued, StageClock::time_point started, StageClock::time_point finished) {
+	processed.fetch_add(1, std::memory_order_relaxed);
+	waitUs.fetch_add(toUs(started - queued), std::memory_order_relaxed);
+	workUs.fetch_add(toUs(finished - started), std::memory_order_relaxed);
+}
+
+void StageStats::updateDepth(size_t depth) {
+	size_t known = maxDepth.load(std::memory_order_relaxed);
+	while (depth > known && !maxDepth.compare_exchange_weak(known, depth, std::memory_order_relaxed));
+}
+
+void StageStats::report(std::ostream& os, const char* name, size_t depth) const {
+	const uint64_t count = processed.load();
+	os << name << ": " << count << " done, depth " << depth << " (max " << maxDepth.load() << ")";
+
+	if (count)
+		os << ", wait " << waitUs.load() / count << " us, work " << workUs.load() / count << " us";
+
+	if (overflowed.load()) os << ", overflowed " << overflowed.load();
+	if (dropped.load()) os << ", dropped " << dropped.load();
+	if (stalls.load()) os << ", stalls " << stalls.load();
+}
+
+/* SerialStage */
+
+SerialStage::SerialStage(size_t capacity, size_t overflowLimit) :
+	queue_(capacity),
+	overflowLimit_(overflowLimit ? overflowLimit : capacity),
+	thread_(&SerialStage::run, this) { }
+
+SerialStage::~SerialStage() {
+	drain();
+
+	quit_ = true;
+	if (thread_.joinable()) thread_.join();
+}
+
+void SerialStage::push(Action action) {
+	if (overflowCount_.load() >= overflowLimit_) {
+		stats_.stalls.fetch_add(1, std::memory_order_relaxed);
+
+		Backoff backoff;
+		while (overflowCount_.load() >= overflowLimit_)
+			backoff.wait();
+	}
+
+	add(Job{ std::move(action), StageClock::now() });
+}
+
+bool SerialStage::tryPush(Action action) {
+	if (overflowCount_.load() >= overflowLimit_) {
+		stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	add(Job{ std::move(action), StageClock::now() });
+	return true;
+}
+
+void SerialStage::add(Job&& job) {
+	// Once something overflowed, the later ones queue up behind it to keep the order
+	if (overflowCount_.load() || !queue_.tryPush(std::move(job))) {
+		std::lock_guard<std::mutex> lock(overflowLock_);
+		overflow_.push_back(std::move(job));
+		++overflowCount_;
+
+		stats_.overflowed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	stats_.updateDepth(++pushed_ - done_.load());
+}
+
+bool SerialStage::takeOverflow(Job& job) {
+	if (!overflowCount_.load()) return false;
+
+	std::lock_guard<std::mutex> lock(overflowLock_);
+	if (overflow_.empty()) return false;
+
+	job = std::move(overflow_.front());
+	overflow_.pop_front();
+	--overflowCount_;
+
+	return true;
+}
+
+void SerialStage::drain() {
+	const uint64_t target = pushed_.load();
+
+	Backoff backoff;
+	while (done_.load() < target)
+		backoff.wait();
+}
+
+void SerialStage::run() {
+	Backoff backoff;
+	Job job;
+
+	while (!quit_) {
+		if (!queue_.tryPop(job) && !takeOverflow(job)) {
+			backoff.wait();
+			continue;
+		}
+
+		backoff.reset();
+
+		const auto started = StageClock::now();
+		job.action();
+		stats_.add(job.queued, started, StageClock::now());
+
+		job.action = nullptr;
+		++done_;
+	}
+}
+
+/* Pipeline */
+
+Pipeline::Pipeline() : parkedLimit_(DEFAULT_MAX_PARKED), lastReport_(StageClock::now()) { }
+
+Pipeline::~Pipeline() {
+	quit_ = true;
+	for (auto& worker : workers_)
+		if (worker.joinable()) worker.join();
+}
+
+void Pipeline::start(const boost::property_tree::ptree& config, std::function<void()> onWorkerStart) {
+	size_t decodeThreads = DEFAULT_DECODE_THREADS;
+	size_t queueSize = DEFAULT_QUEUE_SIZE;
+
+	if (auto section = config.get_child_optional("pipeline")) {
+		decodeThreads = section->get<size_t>("decodeThreads", decodeThreads);
+		queueSize = section->get<size_t>("queueSize", queueSize);
+		parkedLimit_ = section->get<size_t>("maxParked", parkedLimit_);
+		statsInterval_ = std::chrono::seconds(section->get<int64_t>("statsInterval", statsInterval_.count()));
+	}
+
+	decodeThreads = std::max<size_t>(decodeThreads, 1);
+
+	size_t size = 2;
+	while (size < queueSize) size <<= 1;
+
+	mask_ = size - 1;
+	slots_.reset(new Slot[size]);
+	toDecode_.reset(new BoundedQueue<uint64_t>(size));
+
+	for (size_t i = 0; i < decodeThreads; ++i)
+		workers_.emplace_back(&Pipeline::decodeRoutine, this, onWorkerStart);
+}
+
+bool Pipeline::admit() {
+	if (parked_.size() < parkedLimit_) return true;
+
+	applyStats_.dropped.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+bool Pipeline::decode(const char* data, std::size_t size, Handler handler) {
+	return push(data, size, std::move(handler), true);
+}
+
+bool Pipeline::inOrder(const char* data, std::size_t size, Handler handler) {
+	return push(data, size, std::move(handler), false);
+}
+
+bool Pipeline::push(const char* data, std::size_t size, Handler&& handler, bool heavy) {
+	Slot& slot = slots_[produced_ & mask_];
+
+	// Behind the parked ones, to keep the order of arrival
+	if (!parked_.empty() || slot.state.load(std::memory_order_acquire) != Free) {
+		if (!admit()) return false;
+
+		parked_.push_back(Parked{ std::vector<char>(data, data + size), std::move(handler), heavy, StageClock::now() });
+		maxParked_ = std::max(maxParked_, parked_.size());
+		applyStats_.overflowed.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	slot.data.assign(data, data + size);
+	place(slot, std::move(handler), heavy, StageClock::now());
+
+	return true;
+}
+
+void Pipeline::place(Slot& slot, Handler&& handler, bool heavy, StageClock::time_point queued) {
+	slot.heavy = heavy;
+	slot.handler = std::move(handler);
+	slot.queued = queued;
+
+	if (heavy) {
+		slot.state.store(Queued, std::memory_order_release);
+		toDecode_->tryPush(uint64_t(produced_));  // Never full, it's as long as the ring
+	}
+	else {
+		slot.decoded = slot.queued;
+		slot.state.store(Ready, std::memory_order_release);
+	}
+
+	++produced_;
+	decodeStats_.updateDepth(toDecode_->size());
+	applyStats_.updateDepth(depth() + parked_.size());
+}
+
+void Pipeline::unpark() {
+	while (!parked_.empty()) {
+		Slot& slot = slots_[produced_ & mask_];
+		if (slot.state.load(std::memory_order_acquire) != Free) break;
+
+		Parked& parked = parked_.front();
+		slot.data = std::move(parked.data);
+		place(slot, std::move(parked.handler), parked.heavy, parked.queued);
+
+		parked_.pop_front();
+	}
+}
+
+void Pipeline::decodeRoutine(std::function<void()> onStart) {
+	if (onStart) onStart();
+
+	Backoff backoff;
+	uint64_t seq;
+
+	while (!quit_) {
+		if (!toDecode_->tryPop(seq)) {
+			backoff.wait();
+			continue;
+		}
+
+		backoff.reset();
+
+		Slot& slot = slots_[seq & mask_];
+		const auto started = StageClock::now();
+
+		{
+			PerfScope perf(PerfStage::Decode);
+			slot.action = slot.handler(slot.data.data(), slot.data.size());
+		}
+
+		slot.decoded = StageClock::now();
+		decodeStats_.add(slot.queued, started, slot.decoded);
+
+		slot.state.store(Ready, std::memory_order_release);
+	}
+}
+
+void Pipeline::apply(size_t budget) {
+	if (!slots_) return;
+
+	for (; budget > 0 && applied_ < produced_; --budget) {
+		Slot& slot = slots_[applied_ & mask_];
+		if (slot.state.load(std::memory_order_acquire) != Ready) break;
+
+		const auto started = StageClock::now();
+
+		{
+			PerfScope perf(PerfStage::Solver);
+
+			if (!slot.heavy)
+				slot.action = slot.handler(slot.data.data(), slot.data.size());
+
+			if (slot.action) slot.action();
+		}
+
+		applyStats_.add(slot.decoded, started, StageClock::now());
+
+		slot.action = nullptr;
+		slot.handler = nullptr;
+		if (slot.data.capacity() > MAX_KEPT_BUFFER)
+			std::vector<char>().swap(slot.data);
+
+		slot.state.store(Free, std::memory_order_release);
+		++applied_;
+	}
+
+	unpark();
+
+	if (statsInterval_.count() > 0 && StageClock::now() - lastReport_ >= statsInterval_)
+		report();
+}
+
+void Pipeline::addReported(const char* name, const SerialStage* stage) {
+	addReported([name = std::string(name), stage](std::ostream& os) {
+		stage->getStats().report(os, name.c_str(), stage->depth());
+	});
+}
+
+void Pipeline::addReported(std::function<void(std::ostream&)> reporter) {
+	reported_.push_back(std::move(reporter));
+}
+
+void Pipeline::report() {
+	lastReport_ = StageClock::now();
+
+	std::cerr << "Pipeline | ";
+	decodeStats_.report(std::cerr, "decode", toDecode_->size());
+	std::cerr << " | ";
+	applyStats_.report(std::cerr, "apply", depth());
+	if (maxParked_) std::cerr << ", parked " << parked_.size() << " (max " << maxParked_ << ")";
+
+	for (auto& reporter : reported_) {
+		std::cerr << " | ";
+		reporter(std::cerr);
+	}
+
+	std::cerr << std::endl;
+}
+
+} // namespace Credits
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include "csnode/RoundTimeline.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_DEPTH = 128;
+const uint32_t DEFAULT_REPORT_EVERY = 100;
+
+// Senders listed for the per-sender phases
+const size_t SLOWEST_SENDERS = 3;
+
+typedef std::chrono::microseconds Us;
+
+static bool isPerSender(RoundPhase phase) {
+	return phase == RoundPhase::Vector || phase == RoundPhase::Matrix || phase == RoundPhase::Hash;
+}
+
+static int64_t percentile(const std::vector<int64_t>& sorted, unsigned pct) {
+	return sorted[std::min(sorted.size() - 1, sorted.size() * pct / 100)];
+}
+
+RoundTimeline::RoundTimeline() :
+	depth_(DEFAULT_DEPTH),
+	reportEvery_(DEFAULT_REPORT_EVERY) { }
+
+void RoundTimeline::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("timeline");
+	if (!section) return;
+
+	depth_ = std::max<size_t>(section->get<size_t>("depth", depth_), 1);
+	reportEvery_ = section->get<uint32_t>("reportEvery", reportEvery_);
+	dumpFile_ = section->get<std::string>("dumpFile", "");
+}
+
+void RoundTimeline::startRound(uint32_t round, int level) {
+	if (reportEvery_ && started_ && started_ % reportEvery_ == 0)
+		report();
+
+	++started_;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (rounds_.size() >= depth_)
+		rounds_.pop_front();
+
+	rounds_.emplace_back();
+	rounds_.back().round = round;
+	rounds_.back().level = level;
+	rounds_.back().start = std::chrono::steady_clock::now();
+	rounds_.back().events.push_back(RoundEvent{ RoundPhase::RoundTable, boost::asio::ip::address(), Us(0) });
+}
+
+void RoundTimeline::mark(RoundPhase phase, const boost::asio::ip::address& sender) {
+	const auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (rounds_.empty()) return;  // Before the first round
+
+	auto& record = rounds_.back();
+	record.events.push_back(RoundEvent{ phase, sender, std::chrono::duration_cast<Us>(now - record.start) });
+}
+
+std::vector<RoundRecord> RoundTimeline::getRecent() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return std::vector<RoundRecord>(rounds_.begin(), rounds_.end());
+}
+
+bool RoundTimeline::getRound(uint32_t round, RoundRecord& result) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for (auto& record : rounds_) {
+		if (record.round == round) {
+			result = record;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void RoundTimeline::summarize(std::ostream& os) const {
+	const auto rounds = getRecent();
+
+	os << "Timeline of the last " << rounds.size() << " rounds, ms after the round table:" << std::endl;
+
+	for (size_t p = 1; p < (size_t)RoundPhase::Count; ++p) {
+		const auto phase = (RoundPhase)p;
+
+		// The first and the last events of the phase in every round, and every sender's own
+		std::vector<int64_t> firsts, lasts;
+		std::map<boost::asio::ip::address, std::vector<int64_t>> bySender;
+
+		for (auto& record : rounds) {
+			bool seen = false;
+			for (auto& event : record.events) {
+				if (event.phase != phase) continue;
+
+				if (!seen) {
+					firsts.push_back(event.offset.count());
+					lasts.push_back(event.offset.count());
+					seen = true;
+				}
+				else
+					lasts.back() = event.offset.count();
+
+				if (isPerSender(phase))
+					bySender[event.sender].push_back(event.offset.count());
+			}
+		}
+
+		if (firsts.empty()) continue;
+		std::sort(firsts.begin(), firsts.end());
+		std::sort(lasts.begin(), lasts.end());
+
+		os << "  " << getPhaseName(phase) << ": " << firsts.size() << " rounds, p50 " << percentile(firsts, 50) / 1000.0
+		   << ", p90 " << percentile(firsts, 90) / 1000.0 << ", p99 " << percentile(firsts, 99) / 1000.0
+		   << ", max " << firsts.back() / 1000.0;
+
+		if (!bySender.empty()) {
+			os << "; last p50 " << percentile(lasts, 50) / 1000.0 << ", p90 " << percentile(lasts, 90) / 1000.0
+			   << ", max " << lasts.back() / 1000.0;
+
+			std::vector<std::pair<int64_t, boost::asio::ip::address>> medians;
+			for (auto& sender : bySender) {
+				std::sort(sender.second.begin(), sender.second.end());
+				medians.emplace_back(percentile(sender.second, 50), sender.first);
+			}
+
+			std::sort(medians.rbegin(), medians.rend());
+			medians.resize(std::min(medians.size(), SLOWEST_SENDERS));
+
+			os << "; slowest:";
+			for (auto& sender : medians)
+				os << " " << sender.second << " (p50 " << sender.first / 1000.0 << ")";
+		}
+
+		os << std::endl;
+	}
+}
+
+void RoundTimeline::dump(std::ostream& os) const {
+	for (auto& record : getRecent()) {
+		os << "Round " << record.round << ", level " << record.level << ":";
+
+		for (auto& event : record.events) {
+			os << " " << getPhaseName(event.phase);
+			if (!event.sender.is_unspecified())
+				os << "@" << event.sender;
+			os << "=" << event.offset.count() / 1000.0;
+		}
+
+		os << std::endl;
+	}
+}
+
+void RoundTimeline::report() const {
+	summarize(std::cerr);
+
+	if (!dumpFile_.empty()) {
+		std::ofstream file(dumpFile_, std::ios::trunc);
+		summarize(file);
+		dump(file);
+	}
+}
+
+const char* RoundTimeline::getPhaseName(RoundPhase phase) {
+	switch (phase) {
+	case RoundPhase::RoundTable: return "roundTable";
+	case RoundPhase::FirstTransaction: return "firstTransaction";
+	case RoundPhase::BlockCandidate: return "blockCandidate";
+	case RoundPhase::Vector: return "vector";
+	case RoundPhase::Matrix: return "matrix";
+	case RoundPhase::Writer: return "writer";
+	case RoundPhase::BlockSent: return "blockSent";
+	case RoundPhase::BlockReceived: return "blockReceived";
+	case RoundPhase::Hash: return "hash";
+	default: return "unknown";
+	}
+}
+
+} // namespace Credits
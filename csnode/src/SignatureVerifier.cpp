@@ -0,0 +1,142 @@
+#include <algorithm>
+
+#include "csnode/PerfCounters.hpp"
+#include "csnode/SignatureVerifier.hpp"
+
+namespace Credits {
+
+const size_t DEFAULT_VERIFY_THREADS = 2;
+const size_t DEFAULT_CHUNK = 64;
+
+// Pending help requests, one per helper at most for every job
+const size_t JOBS_QUEUE_SIZE = 256;
+
+SignatureVerifier::~SignatureVerifier() {
+	quit_ = true;
+	for (auto& worker : workers_)
+		if (worker.joinable()) worker.join();
+}
+
+void SignatureVerifier::start(const boost::property_tree::ptree& config, std::function<void()> onWorkerStart) {
+	size_t threads = DEFAULT_VERIFY_THREADS;
+
+	if (auto section = config.get_child_optional("verification")) {
+		enabled_ = section->get<bool>("enabled", enabled_);
+		threads = section->get<size_t>("threads", threads);
+		chunk_ = std::max<size_t>(section->get<size_t>("chunk", DEFAULT_CHUNK), 1);
+	}
+
+	if (!enabled_) return;
+
+	jobs_.reset(new BoundedQueue<JobPtr>(JOBS_QUEUE_SIZE));
+	for (size_t i = 0; i < threads; ++i)
+		workers_.emplace_back(&SignatureVerifier::workerRoutine, this, onWorkerStart);
+}
+
+bool SignatureVerifier::verify(const std::vector<csdb::Transaction>& transactions) {
+	PerfScope perf(PerfStage::Verify);
+	return verify(transactions.data(), transactions.size());
+}
+
+bool SignatureVerifier::verify(csdb::Pool& pool) {
+	PerfScope perf(PerfStage::Verify);
+
+	const auto started = StageClock::now();
+	const bool good = pool.verify_signature();
+	stats_.add(started, started, StageClock::now());
+
+	signatures_.fetch_add(1, std::memory_order_relaxed);
+	if (!good) {
+		failures_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return verify(pool.transactions().data(), pool.transactions_count());
+}
+
+bool SignatureVerifier::verify(const csdb::Transaction* transactions, size_t size) {
+	if (!size) return true;
+
+	const auto started = StageClock::now();
+
+	auto job = std::make_shared<Job>();
+	job->transactions = transactions;
+	job->size = size;
+
+	// Asks for help with the chunks beyond the first, as many as there are helpers
+	if (jobs_) {
+		const size_t helpers = std::min(workers_.size(), (size - 1) / chunk_);
+		for (size_t i = 0; i < helpers && jobs_->tryPush(JobPtr(job)); ++i);
+	}
+
+	work(*job);
+
+	// Helpers may still be finishing the chunks they took
+	Backoff backoff;
+	while (job->inFlight.load() != 0)
+		backoff.wait();
+
+	stats_.add(started, started, StageClock::now());
+	signatures_.fetch_add(size, std::memory_order_relaxed);
+
+	if (job->failed) {
+		failures_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+void SignatureVerifier::work(Job& job) {
+	++job.inFlight;
+
+	// The transactions are only touched within a taken chunk of a job not failed yet,
+	// so the caller may leave once nothing is in flight
+	for (;;) {
+		const size_t begin = job.next.fetch_add(chunk_);
+		if (begin >= job.size || job.failed) break;
+
+		const size_t end = std::min(begin + chunk_, job.size);
+		for (size_t i = begin; i < end; ++i) {
+			if (!job.transactions[i].verify_signature()) {
+				job.failed = true;
+				break;
+			}
+		}
+	}
+
+	--job.inFlight;
+}
+
+void SignatureVerifier::workerRoutine(std::function<void()> onStart) {
+	if (onStart) onStart();
+
+	Backoff backoff;
+	JobPtr job;
+
+	while (!quit_) {
+		if (!jobs_->tryPop(job)) {
+			backoff.wait();
+			continue;
+		}
+
+		backoff.reset();
+
+		{
+			PerfScope perf(PerfStage::Verify);
+			work(*job);
+		}
+
+		job.reset();
+	}
+}
+
+void SignatureVerifier::report(std::ostream& os) const {
+	stats_.report(os, "verify", jobs_ ? jobs_->size() : 0);
+	os << ", " << signatures_.load() << " signatures";
+
+	if (failures_.load())
+		os << ", " << failures_.load() << " rejected";
+}
+
+} // namespace Credits
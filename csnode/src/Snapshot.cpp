@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include <net/Logger.hpp>
+
+#include "csnode/Snapshot.hpp"
+
+namespace Credits {
+
+const uint32_t SNAPSHOT_MAGIC = 0x50534e43;  // "CNSP"
+const uint32_t SNAPSHOT_VERSION = 1;
+
+const char DEFAULT_PATH[] = "snapshot.bin";
+const uint32_t DEFAULT_INTERVAL = 100;
+
+/* SnapshotWriter */
+
+SnapshotWriter& SnapshotWriter::operator<<(const std::string& str) {
+	*this << (uint64_t)str.size();
+	data_.append(str);
+	return *this;
+}
+
+SnapshotWriter& SnapshotWriter::operator<<(const csdb::PoolHash& hash) {
+	const auto bytes = hash.to_binary();
+	return *this << std::string(bytes.begin(), bytes.end());
+}
+
+SnapshotWriter& SnapshotWriter::operator<<(const csdb::Address& address) {
+	const auto bytes = address.public_key();
+	return *this << std::string(bytes.begin(), bytes.end());
+}
+
+SnapshotWriter& SnapshotWriter::operator<<(const csdb::TransactionID& id) {
+	return *this << id.pool_hash() << (uint64_t)id.index();
+}
+
+/* SnapshotReader */
+
+SnapshotReader& SnapshotReader::operator>>(std::string& str) {
+	uint64_t size = 0;
+	*this >> size;
+
+	if (!good_ || (uint64_t)(end_ - ptr_) < size) good_ = false;
+	else {
+		str.assign(ptr_, size);
+		ptr_ += size;
+	}
+
+	return *this;
+}
+
+SnapshotReader& SnapshotReader::operator>>(csdb::PoolHash& hash) {
+	std::string bytes;
+	*this >> bytes;
+	hash = csdb::PoolHash::from_binary(csdb::internal::byte_array(bytes.begin(), bytes.end()));
+	return *this;
+}
+
+SnapshotReader& SnapshotReader::operator>>(csdb::Address& address) {
+	std::string bytes;
+	*this >> bytes;
+	address = csdb::Address::from_public_key(csdb::internal::byte_array(bytes.begin(), bytes.end()));
+	return *this;
+}
+
+SnapshotReader& SnapshotReader::operator>>(csdb::TransactionID& id) {
+	csdb::PoolHash hash;
+	uint64_t index = 0;
+	*this >> hash >> index;
+	id = csdb::TransactionID(hash, index);
+	return *this;
+}
+
+/* Snapshot */
+
+Snapshot::Snapshot() :
+	path_(DEFAULT_PATH),
+	interval_(DEFAULT_INTERVAL) { }
+
+void Snapshot::load(const boost::property_tree::ptree& config, const csdb::PoolHash& lastHash) {
+	auto section = config.get_child_optional("snapshot");
+	if (!section) return;
+
+	enabled_ = section->get<bool>("enabled", enabled_);
+	path_ = section->get<std::string>("path", path_);
+	interval_ = section->get<uint32_t>("interval", interval_);
+
+	if (!enabled_) return;
+
+	std::ifstream file(path_, std::ios::binary);
+	if (!file) {
+		LOG_EVENT("No snapshot at " << path_ << ", the caches are built from the chain");
+		return;
+	}
+
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	SnapshotReader in(content.data(), content.size());
+
+	uint32_t magic = 0, version = 0, count = 0;
+	csdb::PoolHash hash;
+	in >> magic >> version >> hash >> count;
+
+	if (!in.good() || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+		LOG_WARN("Bad snapshot at " << path_ << ", ignored");
+		return;
+	}
+
+	if (hash != lastHash) {
+		LOG_EVENT("The snapshot is of block " << hash.to_string() << ", not of the last one, ignored");
+		return;
+	}
+
+	std::map<std::string, std::string> parts;
+	for (uint32_t i = 0; i < count && in.good(); ++i) {
+		std::string name;
+		in >> name;
+		in >> parts[name];
+	}
+
+	if (!in.good() || !in.end()) {
+		LOG_WARN("Bad snapshot at " << path_ << ", ignored");
+		return;
+	}
+
+	loaded_ = std::move(parts);
+	LOG_EVENT("Loaded the snapshot of block " << hash.to_string());
+}
+
+bool Snapshot::restore(const std::string& name, const Loader& loader) const {
+	auto part = loaded_.find(name);
+	if (part == loaded_.end()) return false;
+
+	SnapshotReader in(part->second.data(), part->second.size());
+	if (!loader(in) || !in.good() || !in.end()) {
+		LOG_WARN("Bad snapshot part " << name << ", it is rebuilt from the chain");
+		return false;
+	}
+
+	return true;
+}
+
+void Snapshot::addPart(const std::string& name, Saver saver) {
+	savers_.emplace(name, std::move(saver));
+}
+
+std::string Snapshot::capture() {
+	loaded_.clear();
+
+	SnapshotWriter out;
+	out << (uint32_t)savers_.size();
+
+	for (auto& saver : savers_) {
+		SnapshotWriter part;
+		saver.second(part);
+		out << saver.first << part.data();
+	}
+
+	return std::move(out.data());
+}
+
+void Snapshot::write(const csdb::PoolHash& lastHash, const std::string& captured) const {
+	SnapshotWriter header;
+	header << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << lastHash;
+
+	// Replaces the previous one only when complete
+	const std::string temporary = path_ + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(header.data().data(), header.data().size());
+		file.write(captured.data(), captured.size());
+
+		if (!file.flush()) {
+			LOG_ERROR("Couldn't write the snapshot to " << temporary);
+			return;
+		}
+	}
+
+	if (std::rename(temporary.c_str(), path_.c_str())) {
+		std::remove(path_.c_str());  // Not replaced by rename on Windows
+		if (std::rename(temporary.c_str(), path_.c_str()))
+			LOG_ERROR("Couldn't replace the snapshot at " << path_);
+	}
+}
+
+} // namespace Credits
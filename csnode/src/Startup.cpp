@@ -0,0 +1,64 @@
+#include <iostream>
+
+#include <net/Logger.hpp>
+
+#include "csnode/Startup.hpp"
+
+namespace Credits {
+
+static const char* PHASE_NAMES[] = {
+	"storage ready",
+	"network ready",
+	"API ready",
+	"caches warm"
+};
+
+static_assert(sizeof(PHASE_NAMES) / sizeof(*PHASE_NAMES) == (size_t)StartupPhase::Count, "Phase names missing");
+
+Startup::Startup() : start_(std::chrono::steady_clock::now()) {
+	for (auto& ms : reachedMs_)
+		ms.store(-1);
+}
+
+Startup::~Startup() {
+	for (auto& thread : threads_)
+		thread.join();
+}
+
+int64_t Startup::elapsedMs() const {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+void Startup::reach(StartupPhase phase) {
+	int64_t notReached = -1;
+	const int64_t ms = elapsedMs();
+
+	if (reachedMs_[(size_t)phase].compare_exchange_strong(notReached, ms))
+		LOG_EVENT("Startup: " << PHASE_NAMES[(size_t)phase] << " in " << ms << " ms");
+}
+
+void Startup::addWarmUp(const char* name, WarmUp warmUp) {
+	tasks_.push_back(Task{ name, std::move(warmUp) });
+}
+
+void Startup::startWarmUps(std::function<void()> onThreadStart) {
+	pending_ = tasks_.size();
+	if (tasks_.empty()) {
+		reach(StartupPhase::CachesWarm);
+		return;
+	}
+
+	for (auto& task : tasks_)
+		threads_.emplace_back([this, &task, onThreadStart]() {
+			if (onThreadStart) onThreadStart();
+
+			const int64_t started = elapsedMs();
+			task.warmUp();
+			LOG_EVENT("Startup: " << task.name << " warmed up in " << elapsedMs() - started << " ms");
+
+			if (--pending_ == 0)
+				reach(StartupPhase::CachesWarm);
+		});
+}
+
+} // namespace Credits
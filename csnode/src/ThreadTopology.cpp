@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <net/Logger.hpp>
+
+#include "csnode/ThreadTopology.hpp"
+
+namespace Credits {
+
+static const char* ROLE_NAMES[] = { "other", "network", "storage", "stats", "api", "apiClient", "decode" };
+static_assert(sizeof(ROLE_NAMES) / sizeof(ROLE_NAMES[0]) == (size_t)ThreadRole::Count, "Every role needs a name");
+
+const char* ThreadTopology::getRoleName(ThreadRole role) {
+	return ROLE_NAMES[(size_t)role];
+}
+
+/* "0-2,5" -> 0, 1, 2, 5 */
+static bool parseCpuList(const std::string& str, std::vector<unsigned>& cpus) {
+	std::istringstream input(str);
+	std::string range;
+
+	while (std::getline(input, range, ',')) {
+		unsigned first, last;
+		char dash;
+
+		std::istringstream rangeInput(range);
+		if (!(rangeInput >> first)) return false;
+
+		if (rangeInput >> dash) {
+			if (dash != '-' || !(rangeInput >> last) || last < first) return false;
+		}
+		else
+			last = first;
+
+		for (unsigned cpu = first; cpu <= last; ++cpu)
+			cpus.push_back(cpu);
+	}
+
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+
+	return !cpus.empty();
+}
+
+static bool parsePriority(const std::string& str, ThreadPriority& priority) {
+	if (str == "normal") priority = ThreadPriority::Normal;
+	else if (str == "low") priority = ThreadPriority::Low;
+	else if (str == "high") priority = ThreadPriority::High;
+	else return false;
+
+	return true;
+}
+
+bool ThreadTopology::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("threads");
+	if (!section) return false;
+
+	unsigned cpuCount = std::thread::hardware_concurrency();
+	if (cpuCount == 0) cpuCount = 1;
+
+	std::vector<unsigned> allCpus;
+	for (unsigned cpu = 0; cpu < cpuCount; ++cpu)
+		allCpus.push_back(cpu);
+
+	for (size_t i = 0; i < (size_t)ThreadRole::Count; ++i) {
+		const std::string name = ROLE_NAMES[i];
+		auto& placement = placements_[i];
+
+		const auto cpus = section->get<std::string>(name, "");
+		if (!cpus.empty()) {
+			if (!parseCpuList(cpus, placement.cpus)) {
+				LOG_WARN("Bad CPU list for " << name << " threads: " << cpus);
+				placement.cpus.clear();
+			}
+
+			const auto wrongCpu = std::find_if(placement.cpus.begin(), placement.cpus.end(), [cpuCount](unsigned cpu) { return cpu >= cpuCount; });
+			if (wrongCpu != placement.cpus.end()) {
+				LOG_WARN("There are " << cpuCount << " CPUs only, " << name << " threads are not pinned");
+				placement.cpus.clear();
+			}
+		}
+
+		if (placement.cpus.empty())
+			placement.cpus = allCpus;
+
+		const auto priority = section->get<std::string>(name + "Priority", "normal");
+		if (!parsePriority(priority, placement.priority))
+			LOG_WARN("Bad priority for " << name << " threads: " << priority);
+	}
+
+	auto& network = placements_[(size_t)ThreadRole::Network];
+	if (section->get<bool>("isolateNetwork", false)) {
+		if (network.cpus.size() == cpuCount)
+			LOG_WARN("Cannot isolate the network threads, give them some of the CPUs");
+		else {
+			for (size_t i = 0; i < (size_t)ThreadRole::Count; ++i) {
+				if (i == (size_t)ThreadRole::Network) continue;
+
+				auto& cpus = placements_[i].cpus;
+				std::vector<unsigned> rest;
+				std::set_difference(cpus.begin(), cpus.end(), network.cpus.begin(), network.cpus.end(), std::back_inserter(rest));
+
+				if (rest.empty())
+					LOG_WARN(ROLE_NAMES[i] << " threads share the CPUs with the network ones");
+				else
+					cpus.swap(rest);
+			}
+		}
+	}
+
+	enabled_ = true;
+	return true;
+}
+
+bool ThreadTopology::apply(ThreadRole role, std::thread::native_handle_type handle) const {
+	if (!enabled_) return true;
+
+	const auto& placement = getPlacement(role);
+	bool result = true;
+
+#ifdef _WIN32
+	if (!placement.cpus.empty()) {
+		DWORD_PTR mask = 0;
+		for (auto cpu : placement.cpus)
+			if (cpu < sizeof(mask) * 8) mask |= (DWORD_PTR)1 << cpu;
+
+		result = SetThreadAffinityMask((HANDLE)handle, mask) != 0;
+	}
+
+	if (placement.priority != ThreadPriority::Normal)
+		result = SetThreadPriority((HANDLE)handle, placement.priority == ThreadPriority::High ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_BELOW_NORMAL) && result;
+#else
+	// No affinity API on the other POSIX systems, priorities only
+#ifdef __linux__
+	if (!placement.cpus.empty()) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (auto cpu : placement.cpus)
+			CPU_SET(cpu, &set);
+
+		result = pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+	}
+#endif
+
+	// The round robin policy needs CAP_SYS_NICE, batch is the lower priority hint of Linux
+	if (placement.priority == ThreadPriority::High) {
+		sched_param param{};
+		param.sched_priority = sched_get_priority_min(SCHED_RR);
+		result = pthread_setschedparam(handle, SCHED_RR, &param) == 0 && result;
+	}
+#ifdef SCHED_BATCH
+	else if (placement.priority == ThreadPriority::Low) {
+		sched_param param{};
+		result = pthread_setschedparam(handle, SCHED_BATCH, &param) == 0 && result;
+	}
+#endif
+#endif
+
+	if (!result)
+		LOG_WARN("Cannot set the placement of " << getRoleName(role) << " threads");
+
+	return result;
+}
+
+bool ThreadTopology::applyToCurrent(ThreadRole role) const {
+#ifdef _WIN32
+	return apply(role, (std::thread::native_handle_type)GetCurrentThread());
+#else
+	return apply(role, pthread_self());
+#endif
+}
+
+} // namespace Credits
@@ -0,0 +1,80 @@
+#include <algorithm>
+
+#include "csnode/TransactionCoalescer.hpp"
+
+#include <net/Packet.hpp>
+
+namespace Credits {
+
+const size_t DEFAULT_MAX_COUNT = 1000;
+const size_t DEFAULT_MAX_BYTES = max_length;
+const std::chrono::milliseconds DEFAULT_MAX_DELAY(10);
+
+TransactionCoalescer::TransactionCoalescer(Sender sender) :
+	sender_(sender),
+	maxCount_(DEFAULT_MAX_COUNT),
+	maxBytes_(DEFAULT_MAX_BYTES),
+	maxDelay_(DEFAULT_MAX_DELAY) { }
+
+void TransactionCoalescer::load(const boost::property_tree::ptree& config) {
+	auto section = config.get_child_optional("coalescing");
+	if (!section) return;
+
+	maxCount_ = std::max<size_t>(section->get<size_t>("maxCount", maxCount_), 1);
+	maxBytes_ = section->get<size_t>("maxBytes", maxBytes_);
+	maxDelay_ = std::chrono::milliseconds(section->get<int64_t>("maxDelay", maxDelay_.count()));
+}
+
+void TransactionCoalescer::add(const csdb::Transaction& trans) {
+	if (maxDelay_.count() <= 0) {
+		++sent_;
+		sender_(std::vector<csdb::Transaction>{ trans });
+		return;
+	}
+
+	csdb::internal::byte_counter counter;
+	trans.to_byte_stream(counter);
+
+	if (!batch_.empty() && bytes_ + counter.size() > maxBytes_)
+		flush(Size);
+
+	if (batch_.empty())
+		started_ = Clock::now();
+
+	batch_.push_back(trans);
+	bytes_ += counter.size();
+
+	if (batch_.size() >= maxCount_)
+		flush(Count);
+	else if (bytes_ >= maxBytes_)
+		flush(Size);
+}
+
+void TransactionCoalescer::poll() {
+	if (!batch_.empty() && Clock::now() - started_ >= maxDelay_)
+		flush(Timeout);
+}
+
+void TransactionCoalescer::flush(Reason reason) {
+	if (batch_.empty()) return;
+
+	++flushes_[reason];
+	sent_ += batch_.size();
+
+	std::vector<csdb::Transaction> batch;
+	batch.swap(batch_);
+	bytes_ = 0;
+
+	sender_(std::move(batch));
+}
+
+void TransactionCoalescer::report(std::ostream& os) const {
+	uint64_t batches = 0;
+	for (auto flushes : flushes_)
+		batches += flushes;
+
+	os << "coalescing: " << sent_ << " sent in " << batches << " batches (count " << flushes_[Count]
+	   << ", size " << flushes_[Size] << ", timeout " << flushes_[Timeout] << ", round " << flushes_[Round] << ")";
+}
+
+} // namespace Credits
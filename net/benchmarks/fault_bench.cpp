@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ini_parser.hpp>
+
+#include <net/FaultInjector.hpp>
+#include <net/SessionIO.hpp>
+
+/* Pushes a block through the TaskManager retransmission schedule and a FaultInjector
+   configured by the [faultsOut] section (and its command/peer subsections) of the given
+   ini file. Reports how long the receiver waited for the complete block and how many
+   bytes the sender put on the wire to achieve it.
+
+   Usage: net_fault_bench <config.ini> [block bytes] [runs] */
+
+const auto RUN_TIMEOUT = std::chrono::seconds(30);
+const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+const size_t DEFAULT_RUNS = 20;
+
+struct RunResult {
+	bool delivered;
+	double deliveryMs;
+	uint64_t bytesSent;
+	uint64_t packetsSent;
+};
+
+static std::vector<PacketPtr> makeBlock(PacketManager<2048>& pacman, const uint32_t runId, const size_t blockSize, size_t& lastSize) {
+	const size_t count = std::max<size_t>(1, (blockSize + max_length - 1) / max_length);
+	lastSize = blockSize - (count - 1) * max_length;
+
+	std::vector<PacketPtr> packets;
+	packets.reserve(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		packets.push_back(pacman.getFreePack());
+		Packet& pack = *packets.back();
+
+		memset(&pack, 0, Packet::headerLength());
+		pack.command = CommandList::Redirect;
+		pack.subcommand = SubCommandList::GetBlock;
+		pack.version = Version::version_1;
+		memcpy(pack.HashBlock, &runId, sizeof(runId));
+		pack.header = (uint16_t)i;
+		pack.countHeader = (uint16_t)(count > 1 ? count : 0);
+		memset(pack.data, (int)i, max_length);
+	}
+
+	return packets;
+}
+
+static RunResult runOnce(PacketManager<2048>& pacman, PacketCollector<Hash, 1000, MAX_PART>& collector, FaultInjector& faults, const uint32_t runId, const size_t blockSize) {
+	RunResult result{ false, 0, 0, 0 };
+
+	size_t lastSize;
+	auto packets = makeBlock(pacman, runId, blockSize, lastSize);
+
+	TaskManager taskman;
+	const auto taskId = taskman.add(Task(std::move(packets), lastSize, udp::endpoint(ip::make_address_v4("127.0.0.1"), 9001)));
+
+	// Packets delayed during the previous runs may still come out of the injector
+	FaultInjector::Deliver deliver = [&](PacketPtr pack, std::size_t size, const udp::endpoint&) {
+		if (result.delivered || memcmp(pack->HashBlock, &runId, sizeof(runId)) != 0) return;
+
+		if (pack->countHeader == 0) {
+			result.delivered = true;
+			return;
+		}
+
+		auto packResult = collector.append(pack, size - Packet::headerLength());
+		if (packResult.second && packResult.first->left == 0)
+			result.delivered = true;
+	};
+
+	const auto start = Clock::now();
+	while (!result.delivered && Clock::now() - start < RUN_TIMEOUT) {
+		taskman.run([&](const Task& task) {
+			size_t cntr = 0;
+			for (auto& pack : task.packets) {
+				++cntr;
+				const size_t size = (cntr == task.packets.size() ? task.lastSize : Packet::headerLength() + max_length);
+
+				for (auto& recv : task.receivers) {
+					result.bytesSent += size;
+					++result.packetsSent;
+
+					if (faults.enabled())
+						faults.process(pack, size, recv, deliver);
+					else
+						deliver(pack, size, recv);
+				}
+			}
+		});
+
+		faults.flush(deliver);
+	}
+
+	result.deliveryMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	// Nodes drop the tasks when the round changes, which is when the block is received
+	taskman.remove(taskId);
+
+	return result;
+}
+
+static double percentile(std::vector<double> values, const double p) {
+	if (values.empty()) return 0;
+
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5))];
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <config.ini> [block bytes] [runs]" << std::endl;
+		return 1;
+	}
+
+	boost::property_tree::ptree config;
+	boost::property_tree::read_ini(argv[1], config);
+
+	const size_t blockSize = argc > 2 ? std::stoul(argv[2]) : DEFAULT_BLOCK_SIZE;
+	const size_t runs = argc > 3 ? std::stoul(argv[3]) : DEFAULT_RUNS;
+
+	if (blockSize > (size_t)MAX_PART * max_length) {
+		std::cerr << "Block cannot exceed " << (size_t)MAX_PART * max_length << " bytes" << std::endl;
+		return 1;
+	}
+
+	PacketManager<2048> pacman;
+	PacketCollector<Hash, 1000, MAX_PART> collector;
+
+	FaultInjector faults;
+	if (!faults.load(config, "faultsOut"))
+		std::cerr << "No [faultsOut] section found, running over a perfect link" << std::endl;
+
+	std::vector<double> times;
+	uint64_t totalBytes = 0, totalPackets = 0;
+	size_t lost = 0;
+
+	for (size_t i = 0; i < runs; ++i) {
+		const auto res = runOnce(pacman, collector, faults, (uint32_t)i + 1, blockSize);
+
+		std::cout << "run " << i << ": " << (res.delivered ? "delivered" : "TIMEOUT") << " in " << res.deliveryMs
+			<< " ms, " << res.bytesSent << " bytes in " << res.packetsSent << " packets" << std::endl;
+
+		if (res.delivered)
+			times.push_back(res.deliveryMs);
+		else
+			++lost;
+
+		totalBytes += res.bytesSent;
+		totalPackets += res.packetsSent;
+	}
+
+	const size_t fragments = std::max<size_t>(1, (blockSize + max_length - 1) / max_length);
+	const double payload = (double)blockSize + fragments * Packet::headerLength();
+
+	const auto& stats = faults.getStats();
+
+	std::cout << std::endl
+		<< "block: " << blockSize << " bytes, " << fragments << " fragments, " << runs << " runs, " << lost << " timed out" << std::endl
+		<< "delivery ms: p50 " << percentile(times, 0.5) << ", p90 " << percentile(times, 0.9)
+		<< ", p99 " << percentile(times, 0.99) << ", max " << percentile(times, 1.0) << std::endl
+		<< "bytes sent per block: " << (runs ? totalBytes / runs : 0) << " (x" << (runs ? totalBytes / (payload * runs) : 0) << " of the payload), "
+		<< "packets: " << (runs ? totalPackets / runs : 0) << std::endl
+		<< "injector: passed " << stats.passed << ", dropped " << stats.dropped << ", duplicated " << stats.duplicated
+		<< ", delayed " << stats.delayed << ", reordered " << stats.reordered << std::endl;
+
+	return 0;
+}
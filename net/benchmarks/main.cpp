@@ -0,0 +1,379 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <csdb/address.h>
+#include <csdb/amount.h>
+#include <csdb/currency.h>
+#include <csdb/pool.h>
+#include <csdb/pool_view.h>
+#include <csdb/transaction.h>
+
+#include <net/SessionIO.hpp>
+#include <csnode/Packstream.hpp>
+
+// Same parameters as in SessionIO
+typedef PacketManager<2048> BenchPacketManager;
+typedef PacketCollector<Hash, 1000, MAX_PART> BenchPacketCollector;
+
+static Hash randomHash(std::mt19937_64& rng) {
+	Hash result;
+	for (size_t i = 0; i < hash_length; i += sizeof(uint64_t)) {
+		const uint64_t next = rng();
+		memcpy(result.str + i, &next, std::min(sizeof(uint64_t), hash_length - i));
+	}
+
+	return result;
+}
+
+static std::vector<PacketPtr> makeMessage(BenchPacketManager& pacman, const size_t fragments) {
+	std::vector<PacketPtr> result;
+	for (size_t i = 0; i < fragments; ++i) {
+		result.push_back(pacman.getFreePack());
+		memset(result.back().get(), 0, Packet::headerLength());
+		result.back()->header = (uint16_t)i;
+		result.back()->countHeader = (uint16_t)fragments;
+	}
+
+	return result;
+}
+
+static csdb::Pool makePool(const size_t transactions) {
+	csdb::Pool pool(csdb::PoolHash(), 1);
+
+	char source[publicKey_length], target[publicKey_length];
+	memset(source, 1, sizeof(source));
+	memset(target, 2, sizeof(target));
+
+	for (size_t i = 0; i < transactions; ++i) {
+		csdb::Transaction tr;
+		tr.set_innerID((int64_t)i);
+		tr.set_source(csdb::Address::from_public_key(source));
+		tr.set_target(csdb::Address::from_public_key(target));
+		tr.set_currency(csdb::Currency("CS"));
+		tr.set_amount(csdb::Amount((int32_t)i, 0));
+		tr.set_max_fee(csdb::Amount(1, 0));
+		tr.set_balance(csdb::Amount(1000000, 0));
+		tr.set_signature(std::string(64, 's'));
+		pool.add_transaction(tr);
+	}
+
+	return pool;
+}
+
+//
+// Duplicates filter
+//
+
+// Every message is seen about four times: the original and the redirects
+static void bm_circular_map(benchmark::State& state) {
+	std::mt19937_64 rng(1);
+	CircularMap<Hash, uint32_t, 50000> map;
+
+	std::vector<Hash> keys;
+	for (size_t i = 0; i < 100000; ++i)
+		keys.push_back(randomHash(rng));
+
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(map.pushAndIncrease(keys[(i >> 2) % keys.size()]));
+		++i;
+	}
+}
+BENCHMARK(bm_circular_map);
+
+//
+// Reassembly
+//
+
+static void bm_packet_collector(benchmark::State& state) {
+	BenchPacketManager pacman;
+	BenchPacketCollector collector;
+
+	const size_t fragments = (size_t)state.range(0);
+	auto message = makeMessage(pacman, fragments);
+
+	uint64_t counter = 0;
+	for (auto _ : state) {
+		++counter;
+		for (auto& pack : message)
+			memcpy(pack->HashBlock, &counter, sizeof(counter));
+
+		for (auto& pack : message)
+			benchmark::DoNotOptimize(collector.append(pack, max_length));
+	}
+
+	state.SetItemsProcessed(state.iterations() * fragments);
+}
+BENCHMARK(bm_packet_collector)->Arg(2)->Arg(16)->Arg(256)->Arg(MAX_PART);
+
+static void bm_packet_part_combine(benchmark::State& state) {
+	BenchPacketManager pacman;
+	BenchPacketCollector collector;
+
+	const size_t fragments = (size_t)state.range(0);
+	auto message = makeMessage(pacman, fragments);
+
+	std::pair<PacketPart*, bool> part;
+	for (auto& pack : message)
+		part = collector.append(pack, max_length);
+
+	std::vector<char> combined(fragments * max_length);
+	for (auto _ : state)
+		benchmark::DoNotOptimize(part.first->combine(combined.data()));
+
+	state.SetBytesProcessed(state.iterations() * fragments * max_length);
+}
+BENCHMARK(bm_packet_part_combine)->Arg(2)->Arg(16)->Arg(256);
+
+//
+// Nodes ring
+//
+
+// Mostly known senders with the occasional newcomer evicting the oldest one
+static void bm_nodes_ring(benchmark::State& state) {
+	NodesRing<500> ring;
+	std::mt19937 rng(1);
+
+	std::vector<udp::endpoint> endpoints;
+	for (uint32_t i = 0; i < 550; ++i)
+		endpoints.emplace_back(ip::make_address_v4(0x0A000000 + i), 9001);
+
+	for (auto _ : state) {
+		auto ep = endpoints[rng() % endpoints.size()];
+		benchmark::DoNotOptimize(ring.place(std::move(ep)));
+	}
+}
+BENCHMARK(bm_nodes_ring);
+
+//
+// Packets
+//
+
+static void bm_packet_manager(benchmark::State& state) {
+	BenchPacketManager pacman;
+
+	const size_t batch = (size_t)state.range(0);
+	std::vector<PacketPtr> packets;
+	packets.reserve(batch);
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < batch; ++i)
+			packets.push_back(pacman.getFreePack());
+		packets.clear();
+	}
+
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(bm_packet_manager)->Arg(1)->Arg(64)->Arg(MAX_PART);
+
+// Random places of a full page of packets, as the collector and the hasher read them:
+// bound by the TLB, the argument is the page backing
+static void bm_packet_page_touch(benchmark::State& state) {
+	BenchPacketManager pacman;
+	pacman.setBacking((PageBacking)state.range(0));
+
+	std::vector<PacketPtr> packets;
+	for (size_t i = 0; i < 2048; ++i)
+		packets.push_back(pacman.getFreePack());
+
+	std::mt19937_64 rng(1);
+	std::vector<std::pair<uint32_t, uint32_t>> places(1 << 16);
+	for (auto& place : places)
+		place = std::make_pair((uint32_t)(rng() % packets.size()), (uint32_t)(rng() % max_length));
+
+	size_t i = 0;
+	for (auto _ : state) {
+		const auto& place = places[i++ & (places.size() - 1)];
+		Packet* pack = packets[place.first].get();
+
+		++pack->data[place.second];
+		benchmark::DoNotOptimize(pack->header);
+	}
+
+	state.SetLabel(LargeBuffer::getBackingName((PageBacking)state.range(0)));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_packet_page_touch)->Arg((int)PageBacking::Regular)->Arg((int)PageBacking::Transparent)->Arg((int)PageBacking::Explicit);
+
+static void bm_message_hasher(benchmark::State& state) {
+	MessageHasher<BLAKE2_HASH_LENGTH> hasher;
+	hasher.init(PublicKey());
+
+	std::vector<char> data((size_t)state.range(0), 'x');
+	char out[hash_length];
+
+	for (auto _ : state) {
+		hasher.nextHash(data.data(), data.size(), out);
+		benchmark::DoNotOptimize(out);
+	}
+
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(bm_message_hasher)->Arg(40)->Arg(1024)->Arg(max_length);
+
+//
+// Retransmission
+//
+
+static void bm_task_manager(benchmark::State& state) {
+	BenchPacketManager pacman;
+	TaskManager taskman;
+
+	const size_t tasks = (size_t)state.range(0);
+	for (size_t i = 0; i < tasks; ++i)
+		taskman.add(Task(makeMessage(pacman, 1), 100, udp::endpoint(ip::make_address_v4(0x0A000000 + (uint32_t)i), 9001)));
+
+	size_t launched = 0;
+	for (auto _ : state)
+		taskman.run([&launched](const Task&) { ++launched; });
+
+	state.counters["launched"] = (double)launched;
+}
+BENCHMARK(bm_task_manager)->Arg(10)->Arg(100)->Arg(1000);
+
+static void bm_task_manager_add_remove(benchmark::State& state) {
+	BenchPacketManager pacman;
+	TaskManager taskman;
+
+	const udp::endpoint ep(ip::make_address_v4("10.0.0.1"), 9001);
+	for (auto _ : state) {
+		auto id = taskman.add(Task(makeMessage(pacman, 1), 100, udp::endpoint(ep)));
+		taskman.remove(id);
+	}
+}
+BENCHMARK(bm_task_manager_add_remove);
+
+//
+// Serialization
+//
+
+static void bm_opackstream_round_table(benchmark::State& state) {
+	BenchPacketManager pacman;
+	OPackStream stream(&pacman);
+
+	const Credits::NodeId node = ip::make_address_v4("10.0.0.1");
+	for (auto _ : state) {
+		stream.init();
+		stream << (uint32_t)1 << node << node << node << node;
+		benchmark::DoNotOptimize(stream.lastSize());
+	}
+}
+BENCHMARK(bm_opackstream_round_table);
+
+static void bm_opackstream_pool(benchmark::State& state) {
+	BenchPacketManager pacman;
+	OPackStream stream(&pacman);
+
+	const size_t transactions = (size_t)state.range(0);
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto pool = makePool(transactions);
+		state.ResumeTiming();
+
+		stream.init();
+		stream << pool;
+		benchmark::DoNotOptimize(stream.get().size());
+	}
+
+	state.SetItemsProcessed(state.iterations() * transactions);
+}
+BENCHMARK(bm_opackstream_pool)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void bm_ipackstream_pool(benchmark::State& state) {
+	const size_t transactions = (size_t)state.range(0);
+	auto pool = makePool(transactions);
+
+	uint32_t size;
+	const char* data = pool.to_byte_stream(size);
+
+	IPackStream stream;
+	for (auto _ : state) {
+		stream.init(data, size);
+
+		csdb::Pool decoded;
+		stream >> decoded;
+		benchmark::DoNotOptimize(decoded.transactions_count());
+	}
+
+	state.SetItemsProcessed(state.iterations() * transactions);
+}
+BENCHMARK(bm_ipackstream_pool)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void bm_ipackstream_pool_view(benchmark::State& state) {
+	const size_t transactions = (size_t)state.range(0);
+	auto pool = makePool(transactions);
+
+	uint32_t size;
+	const char* data = pool.to_byte_stream(size);
+
+	IPackStream stream;
+	for (auto _ : state) {
+		stream.init(data, size);
+
+		csdb::PoolView view;
+		stream >> view;
+
+		int64_t sum = 0;
+		for (auto& tr : view)
+			sum += tr.innerID();
+
+		benchmark::DoNotOptimize(sum);
+	}
+
+	state.SetItemsProcessed(state.iterations() * transactions);
+}
+BENCHMARK(bm_ipackstream_pool_view)->Arg(100)->Arg(1000)->Arg(10000);
+
+//
+// End-to-end: receive N fragments -> reassemble -> decode Pool
+//
+
+static void bm_receive_block(benchmark::State& state) {
+	BenchPacketManager pacman;
+	BenchPacketCollector collector;
+
+	const size_t transactions = (size_t)state.range(0);
+
+	OPackStream ostream(&pacman);
+	ostream.init();
+	ostream << makePool(transactions);
+
+	auto fragments = ostream.get();
+	const size_t lastSize = ostream.lastSize();
+	for (size_t i = 0; i < fragments.size(); ++i) {
+		fragments[i]->header = (uint16_t)i;
+		fragments[i]->countHeader = (uint16_t)fragments.size();
+	}
+
+	std::vector<char> combined(fragments.size() * max_length);
+	IPackStream istream;
+
+	uint64_t counter = 0;
+	for (auto _ : state) {
+		state.PauseTiming();
+		++counter;
+		for (auto& pack : fragments)
+			memcpy(pack->HashBlock, &counter, sizeof(counter));
+		state.ResumeTiming();
+
+		std::pair<PacketPart*, bool> part;
+		for (size_t i = 0; i < fragments.size(); ++i)
+			part = collector.append(fragments[i], i + 1 == fragments.size() ? lastSize : max_length);
+
+		const size_t size = part.first->combine(combined.data());
+		istream.init(combined.data(), size);
+
+		csdb::Pool pool;
+		istream >> pool;
+		benchmark::DoNotOptimize(pool.transactions_count());
+	}
+
+	state.counters["fragments"] = (double)fragments.size();
+	state.SetItemsProcessed(state.iterations() * transactions);
+}
+BENCHMARK(bm_receive_block)->Arg(100)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "Logger.hpp"
+#include "Packet.hpp"
+#include "Structures.hpp"
+
+// Impairment applied to the packets of one direction. Rates are probabilities in [0, 1],
+// delays are added on top of the real network latency
+struct FaultRule {
+	double dropRate = 0;
+	double duplicateRate = 0;
+	double reorderRate = 0;
+
+	std::chrono::milliseconds delayMin{ 0 };
+	std::chrono::milliseconds delayMax{ 0 };
+	std::chrono::milliseconds delayMean{ 0 };  // Exponential distribution only
+	bool exponentialDelay = false;
+
+	std::chrono::milliseconds reorderDelay{ 10 }; // Hold time of a packet pushed behind its successors
+
+	void load(const boost::property_tree::ptree& section, const FaultRule& base) {
+		dropRate = section.get<double>("drop", base.dropRate);
+		duplicateRate = section.get<double>("duplicate", base.duplicateRate);
+		reorderRate = section.get<double>("reorder", base.reorderRate);
+
+		delayMin = std::chrono::milliseconds(section.get<int64_t>("delayMin", base.delayMin.count()));
+		delayMax = std::chrono::milliseconds(section.get<int64_t>("delayMax", base.delayMax.count()));
+		delayMean = std::chrono::milliseconds(section.get<int64_t>("delayMean", base.delayMean.count()));
+		reorderDelay = std::chrono::milliseconds(section.get<int64_t>("reorderDelay", base.reorderDelay.count()));
+
+		const auto distribution = section.get<std::string>("delayDistribution", base.exponentialDelay ? "exponential" : "uniform");
+		exponentialDelay = (distribution == "exponential");
+
+		if (delayMax < delayMin) delayMax = delayMin;
+	}
+};
+
+struct FaultStats {
+	uint64_t passed = 0;
+	uint64_t dropped = 0;
+	uint64_t duplicated = 0;
+	uint64_t delayed = 0;
+	uint64_t reordered = 0;
+};
+
+/* Optional shim between SessionIO and its sockets. Packets are dropped, duplicated,
+   delayed or reordered according to the default rule of the section, or to a rule
+   configured for the command ("<section>:cmd:<CommandList value>") or the peer
+   ("<section>:peer:<ip>"); the peer rule wins. Delayed packets are kept in a queue
+   that has to be flushed from the owning event loop */
+class FaultInjector {
+public:
+	typedef std::function<void(PacketPtr, std::size_t, const udp::endpoint&)> Deliver;
+
+	bool load(const boost::property_tree::ptree& config, const std::string& section) {
+		auto root = config.find(section);
+		if (root == config.not_found()) return false;
+
+		defaultRule_.load(root->second, FaultRule());
+		rng_.seed(root->second.get<uint64_t>("seed", std::random_device()()));
+
+		const std::string cmdPrefix = section + ":cmd:";
+		const std::string peerPrefix = section + ":peer:";
+
+		for (auto& child : config) {
+			if (child.first.compare(0, cmdPrefix.size(), cmdPrefix) == 0) {
+				const std::string value = child.first.substr(cmdPrefix.size());
+
+				char* end = nullptr;
+				const long cmd = std::strtol(value.c_str(), &end, 10);
+				if (value.empty() || *end != '\0' || cmd < 0 || cmd > UINT8_MAX) {
+					LOG_WARN("Bad command in fault section [" << child.first << "], skipped");
+					continue;
+				}
+
+				commandRules_[(char)cmd].load(child.second, defaultRule_);
+			}
+			else if (child.first.compare(0, peerPrefix.size(), peerPrefix) == 0) {
+				boost::system::error_code ec;
+				const auto addr = ip::make_address(child.first.substr(peerPrefix.size()), ec);
+				if (ec) {
+					LOG_WARN("Bad address in fault section [" << child.first << "], skipped");
+					continue;
+				}
+
+				peerRules_[addr].load(child.second, defaultRule_);
+			}
+		}
+
+		enabled_ = true;
+		LOG_NOTICE("Fault injection enabled for [" << section << "]: drop " << defaultRule_.dropRate
+			<< ", delay " << defaultRule_.delayMin.count() << "-" << defaultRule_.delayMax.count() << "ms"
+			<< ", duplicate " << defaultRule_.duplicateRate << ", reorder " << defaultRule_.reorderRate
+			<< ", " << commandRules_.size() << " command and " << peerRules_.size() << " peer rules");
+
+		return true;
+	}
+
+	bool enabled() const { return enabled_; }
+
+	const FaultStats& getStats() const { return stats_; }
+
+	void process(PacketPtr pack, const std::size_t size, const udp::endpoint& ep, const Deliver& deliver) {
+		const FaultRule& rule = findRule(pack->command, ep.address());
+
+		if (roll(rule.dropRate)) {
+			++stats_.dropped;
+			return;
+		}
+
+		const uint32_t copies = roll(rule.duplicateRate) ? 2 : 1;
+		if (copies > 1) ++stats_.duplicated;
+
+		for (uint32_t i = 0; i < copies; ++i) {
+			auto delay = nextDelay(rule);
+
+			if (roll(rule.reorderRate)) {
+				delay += rule.reorderDelay;
+				++stats_.reordered;
+			}
+
+			if (delay.count() == 0) {
+				++stats_.passed;
+				deliver(pack, size, ep);
+			}
+			else {
+				++stats_.delayed;
+				delayed_.push(Delayed{ Clock::now() + delay, nextSeq_++, pack, size, ep });
+			}
+		}
+	}
+
+	// Releases the delayed packets which are due
+	void flush(const Deliver& deliver) {
+		if (delayed_.empty()) return;
+
+		const auto now = Clock::now();
+		while (!delayed_.empty() && delayed_.top().when <= now) {
+			Delayed next = delayed_.top();
+			delayed_.pop();
+
+			++stats_.passed;
+			deliver(next.pack, next.size, next.ep);
+		}
+	}
+
+	std::size_t pending() const { return delayed_.size(); }
+
+private:
+	struct Delayed {
+		Clock::time_point when;
+		uint64_t seq;
+
+		PacketPtr pack;
+		std::size_t size;
+		udp::endpoint ep;
+
+		bool operator>(const Delayed& rhs) const {
+			return when > rhs.when || (when == rhs.when && seq > rhs.seq);
+		}
+	};
+
+	const FaultRule& findRule(const char cmd, const ip::address& addr) const {
+		if (!peerRules_.empty()) {
+			auto peer = peerRules_.find(addr);
+			if (peer != peerRules_.end()) return peer->second;
+		}
+
+		if (!commandRules_.empty()) {
+			auto command = commandRules_.find(cmd);
+			if (command != commandRules_.end()) return command->second;
+		}
+
+		return defaultRule_;
+	}
+
+	bool roll(const double rate) {
+		return rate > 0 && std::uniform_real_distribution<double>(0, 1)(rng_) < rate;
+	}
+
+	std::chrono::milliseconds nextDelay(const FaultRule& rule) {
+		if (rule.delayMax.count() == 0) return rule.delayMax;
+
+		int64_t ms;
+		if (rule.exponentialDelay && rule.delayMean.count() > 0) {
+			ms = rule.delayMin.count() + (int64_t)std::exponential_distribution<double>(1.0 / rule.delayMean.count())(rng_);
+			ms = std::min(ms, (int64_t)rule.delayMax.count());
+		}
+		else
+			ms = std::uniform_int_distribution<int64_t>(rule.delayMin.count(), rule.delayMax.count())(rng_);
+
+		return std::chrono::milliseconds(ms);
+	}
+
+	bool enabled_ = false;
+
+	FaultRule defaultRule_;
+	std::unordered_map<char, FaultRule> commandRules_;
+	std::map<ip::address, FaultRule> peerRules_;
+
+	std::mt19937_64 rng_;
+	uint64_t nextSeq_ = 0;
+	std::priority_queue<Delayed, std::vector<Delayed>, std::greater<Delayed>> delayed_;
+
+	FaultStats stats_;
+};
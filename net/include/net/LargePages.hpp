@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+#include <boost/property_tree/ptree.hpp>
+
+enum class PageBacking {
+	Regular,      // The heap
+	Transparent,  // 2 MB aligned, the kernel is advised to back it by huge pages
+	Explicit      // Reserved huge pages (MAP_HUGETLB)
+};
+
+/* Memory of a large buffer taken at once, backed by 2 MB pages when asked for to
+   spare the TLB. When there are no reserved huge pages, the transparent ones are
+   tried, then the heap, so asking never fails where the heap would not. The backing
+   of every buffer kind is chosen by the optional [hugepages] section:
+
+     packets=regular     ; regular, transparent or explicit
+     reassembly=regular */
+class LargeBuffer {
+public:
+	LargeBuffer() = default;
+	LargeBuffer(size_t size, PageBacking wanted);
+	~LargeBuffer();
+
+	LargeBuffer(LargeBuffer&&) noexcept;
+	LargeBuffer& operator=(LargeBuffer&&) noexcept;
+
+	LargeBuffer(const LargeBuffer&) = delete;
+	LargeBuffer& operator=(const LargeBuffer&) = delete;
+
+	char* data() const { return data_; }
+
+	// At least the size asked for, rounded up to whole huge pages when backed by them
+	size_t size() const { return size_; }
+
+	PageBacking getBacking() const { return backing_; }
+
+	static PageBacking getBacking(const boost::property_tree::ptree& config, const char* kind);
+	static const char* getBackingName(PageBacking);
+
+private:
+	void release();
+
+	char* data_ = nullptr;
+	size_t size_ = 0;
+	PageBacking backing_ = PageBacking::Regular;
+};
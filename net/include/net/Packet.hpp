@@ -5,6 +5,7 @@
 #include <cstring>
 
 #include "Hash.hpp"
+#include "LargePages.hpp"
 
 enum CommandList {
 	Registration = 1,         
@@ -33,7 +34,10 @@ enum CommandList {
 	RegistrationConnectionRefused = 25,
 	SendBlockCandidate = 28,
 	GetBlockCandidate = 29,
-	GetFirstTransaction = 30
+	GetFirstTransaction = 30,
+	GetCompactCandidate = 31,       // Block candidate as short transaction ids
+	GetCandidateRequest = 32,       // Its transactions missing at a confidant
+	GetCandidateTransactions = 33   // The answer of the main node
 };
 
 
@@ -49,7 +53,8 @@ enum SubCommandList {
 	SGetVector,
 	SGetMatrix,
 	SGetHash,
-	SGetIpTable
+	SGetIpTable,
+	RegistrationLevelObserver  // Registers a node that takes no consensus roles
 };
 
 enum Version {
@@ -153,13 +158,11 @@ template <size_t PageSize>
 class PacketManager {
 public:
 	PacketManager() { 
-		allocateNewPage();
 		PacketPtr::freeFunc = [this](PacketPtr* p) { freeMem(p); };
 	}
 
-	~PacketManager() {
-		for (PacketWithCounter* p : pages_) free(p);
-	}
+	// The pages are taken on demand, the ones from now on are backed so
+	void setBacking(PageBacking backing) { backing_ = backing; }
 
 	PacketPtr getFreePack() {
 		if (freeStack_.empty())
@@ -177,15 +180,21 @@ public:
 
 private:
 	void allocateNewPage() {
-		pages_.push_back((PacketWithCounter*)malloc(sizeof(PacketWithCounter) * PageSize));
-		freeStack_.reserve(pages_.size() * PageSize);
+		pages_.emplace_back(sizeof(PacketWithCounter) * PageSize, backing_);
+
+		// Rounded up to huge pages, the rest takes packets as well
+		const size_t count = pages_.back().size() / sizeof(PacketWithCounter);
+		packets_ += count;
+		freeStack_.reserve(packets_);
 
-		PacketWithCounter* ptr = pages_.back();
-		for (size_t i = 0; i < PageSize; ++i, ++ptr)
+		PacketWithCounter* ptr = (PacketWithCounter*)pages_.back().data();
+		for (size_t i = 0; i < count; ++i, ++ptr)
 			freeStack_.push_back(ptr);
 	}
 
-	std::vector<PacketWithCounter*> pages_;
+	PageBacking backing_ = PageBacking::Regular;
+	std::vector<LargeBuffer> pages_;
+	size_t packets_ = 0;
 	std::vector<PacketWithCounter*> freeStack_;
 };
 
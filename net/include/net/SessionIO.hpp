@@ -17,6 +17,8 @@
 
 #include "Structures.hpp"
 #include "Packet.hpp"
+#include "FaultInjector.hpp"
+#include "StreamChannel.hpp"
 
 using boost::asio::ip::udp;
 using namespace boost::asio;
@@ -29,6 +31,7 @@ const unsigned MAX_PART = 2048;
 namespace Credits {
 	class ISolver;
 	class Node;
+	class ThreadTopology;
 }
 
 
@@ -46,6 +49,7 @@ public:
 
 	// Talking to Node
 	void addToRingBuffer(const boost::asio::ip::address&);
+	std::vector<ip::address> getRingAddresses() const;
 
 	template <typename CallBack, typename... Args>
 	void waitOnTimer(const std::chrono::milliseconds& timeout, CallBack cb, Args... args) {
@@ -61,10 +65,21 @@ public:
 	TaskId addTaskDirect(std::vector<PacketPtr>&& packets, const CommandList cmd, const SubCommandList smd, const size_t lastSize, const ip::address& ip);
 	TaskId addTaskBroadcast(std::vector<PacketPtr>&&, const SubCommandList, const size_t lastSize);
 
+	// Large messages go by the stream channel when it's configured, the rest as tasks
+	void sendBulkDirect(std::vector<PacketPtr>&&, const CommandList, const SubCommandList, const size_t lastSize, const ip::address&);
+	void sendBulkBroadcast(std::vector<PacketPtr>&&, const SubCommandList, const size_t lastSize);
+
 	void removeTask(TaskId tId) { m_taskman.remove(tId); }
 	void removeAllTasks() { m_taskman.clear(); }
 
+	const Credits::ThreadTopology& getThreadTopology() const { return *m_topology; }
+	const boost::property_tree::ptree& getConfig() const { return m_config; }
+
+	bool isObserver() const { return m_observer; }
+
 private:
+	boost::property_tree::ptree m_config;  // Configure.ini
+
 	ip::address MyIp_;
 	Hash MyHash_;            //Hash of the node
 	PublicKey MyPublicKey_;  //Public key of the node
@@ -101,21 +116,43 @@ private:
 	TaskManager m_taskman;
 	std::thread m_senderThread;
 
-	char* m_combinedData;
+	FaultInjector m_outFaults;                      // Optional impairment of the outgoing traffic
+	FaultInjector m_inFaults;                       // Optional impairment of the incoming traffic
+
+	std::unique_ptr<Credits::ThreadTopology> m_topology;  // CPUs and priorities of the node threads
+
+	StreamChannel m_stream;                         // Optional reliable channel for the bulk messages
+
+	/* Observer mode, for the nodes that only follow the chain and serve the API.
+	   They run no solver, the transactions submitted to the API are relayed to the
+	   main node. Configured by the optional [observer] section:
+
+	     enabled=false
+	     redirect=true       ; Still redirects the blocks and the round tables */
+	bool m_observer = false;
+	bool m_observerRedirect = true;
+
+	LargeBuffer m_combinedData;
 
 	bool Initialization();
 
 	
     //Method of receiving information
-	inline void InputServiceHandleReceive(PacketPtr message, const boost::system::error_code & error, std::size_t bytes_transferred);
+	inline void InputServiceHandleReceive(PacketPtr message, const boost::system::error_code & error, std::size_t bytes_transferred, const udp::endpoint& sender);
+	void StreamHandleReceive(const Packet& header, const char* data, std::size_t size, const ip::address& sender);
+	inline void processMessage(const Packet& message, const char* data, std::size_t size);
 	void outputHandleSend(PacketPtr message, const boost::system::error_code& error, std::size_t bytes_transferred);
 
 	//Sending info
 	inline void createSendTasks(const std::vector<PacketPtr>&, const CommandList, const SubCommandList, const size_t lastSize);
+	inline bool isBulk(const std::vector<PacketPtr>&, const size_t lastSize) const;
 
 	inline void outFrmPack(const PacketPtr, const CommandList, const SubCommandList, const Version, const size_t size_data);
 	inline void outSendPack(PacketPtr, std::size_t, const udp::endpoint*);
 	inline void handleSend(PacketPtr, std::size_t, const udp::endpoint&);
+	inline void sendPack(PacketPtr, std::size_t, const udp::endpoint&);
+
+	inline void flushFaults();
 
 	void senderThreadRoutine();
 
@@ -129,6 +166,12 @@ private:
 	//Method of sending information to nodes
 	inline bool RunRedirect(PacketPtr, std::size_t);
 	inline uint32_t getBackDataCounter(PacketPtr);
+	inline uint32_t getBackDataCounter(const char* hashBlock, const uint16_t header);
+	inline bool isNewMessage(const Packet& header);
+	inline void forgetMessage(const Packet& header);  // Seen no more, taken when sent again
+
+	// The blocks and the round tables, all an observer takes
+	inline bool isObserved(const Packet&) const;
 
 	inline void RegistrationToServer();
 
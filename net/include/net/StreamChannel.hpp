@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "Packet.hpp"
+#include "Structures.hpp"
+
+/* Optional reliable side-channel for the bulk messages: block candidates and full
+   blocks. Configured by the [stream] section of Configure.ini:
+
+     port=9002            ; TCP port, the same for the whole network
+     threshold=65536      ; Messages of this many bytes and more go by stream
+     unixSocketDir=/tmp   ; Co-located nodes talk over <dir>/<ip>.sock instead
+     maxQueued=64         ; Messages waiting for a peer, the ones beyond go by UDP
+     maxPending=16        ; Incoming connections still in their hello, the ones beyond are closed
+
+   A message is framed as its total size, the packet header of its first fragment
+   and the combined data of all the fragments. Connections start with a hello of
+   both sides carrying the protocol version, so peers without the channel or of
+   another version are detected on the first send; the message and the ones
+   queued behind it are then handed back for the UDP path and the peer is not
+   retried for a while. The address a TCP peer declares in its hello must be the
+   one it connects from, the messages are attributed to it. An incoming connection
+   is closed when its hello or a started frame takes too long.
+
+   Outgoing connections only send and incoming ones only receive. Everything runs
+   on the io_service of the owner */
+class StreamChannel {
+public:
+	typedef boost::asio::generic::stream_protocol Protocol;
+	typedef basic_socket_acceptor<Protocol> Acceptor;
+
+	// The header, then the whole data
+	typedef std::function<void(const Packet&, const char*, std::size_t, const ip::address&)> Handler;
+
+	// Undelivered message to send by UDP: the fragments and the data size of the last one
+	typedef std::function<void(std::vector<PacketPtr>&&, std::size_t, const ip::address&)> Fallback;
+
+	explicit StreamChannel(io_service&);
+	~StreamChannel();
+
+	bool load(const boost::property_tree::ptree& config, const ip::address& myIp);
+	bool start(Handler, Fallback);
+
+	bool enabled() const { return enabled_; }
+	std::size_t getThreshold() const { return threshold_; }
+
+	// False if the peer is known to have no channel or too much is queued for it,
+	// the caller uses UDP then
+	bool send(const ip::address& peer, const std::vector<PacketPtr>& packets, std::size_t lastSize);
+
+private:
+	struct Hello {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t ip;  // The sockets may be local
+	};
+
+	struct Message {
+		std::vector<PacketPtr> packets;
+		std::size_t lastSize;
+		uint32_t frameSize;
+	};
+
+	struct Outgoing {
+		Outgoing(io_service& service) : socket(service), timer(service) { }
+
+		Protocol::socket socket;
+		steady_timer timer;  // Connection and hello
+		Hello hello;
+		bool ready = false;
+		bool writing = false;
+		std::deque<Message> queue;
+	};
+
+	struct Incoming {
+		Incoming(io_service& service) : socket(service), timer(service) { }
+
+		Protocol::socket socket;
+		steady_timer timer;  // Hello and frame
+		bool pending = false;  // In the hello
+		Hello hello;
+		uint32_t frameSize;
+		std::vector<char> frame;
+	};
+
+	typedef std::shared_ptr<Outgoing> OutgoingPtr;
+	typedef std::shared_ptr<Incoming> IncomingPtr;
+
+	bool listen(std::unique_ptr<Acceptor>&, const Protocol::endpoint&);
+	void accept(Acceptor&);
+
+	void readHello(IncomingPtr);
+	bool isDeclaredPeer(const Incoming&) const;
+	void readFrame(IncomingPtr);
+	void setDeadline(IncomingPtr);
+	void settle(Incoming&);
+	void drop(IncomingPtr);
+
+	void connect(const ip::address&, OutgoingPtr);
+	void writeNext(const ip::address&, OutgoingPtr);
+	void fail(const ip::address&, OutgoingPtr, const boost::system::error_code&);
+
+	Protocol::endpoint getPeerEndpoint(const ip::address&) const;
+	std::string getSocketPath(const ip::address&) const;
+
+	io_service& service_;
+
+	bool enabled_ = false;
+	ip::address myIp_;
+	unsigned short port_ = 9002;
+	std::size_t threshold_ = 64 * 1024;
+	std::size_t maxQueued_ = 64;
+	std::size_t maxPending_ = 16;
+	std::size_t pending_ = 0;
+	std::string unixSocketDir_;
+
+	Handler handler_;
+	Fallback fallback_;
+
+	std::unique_ptr<Acceptor> tcpAcceptor_;
+	std::unique_ptr<Acceptor> unixAcceptor_;
+
+	std::map<ip::address, OutgoingPtr> outgoing_;
+	std::map<ip::address, Clock::time_point> refused_;
+};
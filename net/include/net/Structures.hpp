@@ -45,6 +45,11 @@ public:
 		return place->second;
 	}
 
+	// The key keeps its place in the eviction order, it is only evicted earlier
+	void erase(const Key& key) {
+		map_.erase(key);
+	}
+
 private:
 	MapType map_;
 	std::deque<Key> queue_;
@@ -64,6 +69,9 @@ struct PacketPart {
 	size_t left;
 	size_t size;
 
+	size_t passed = 0;    // Fragments passed on in order, before the whole sequence
+	size_t lastSize = 0;
+
 	bool tryInsert(PacketPtr pack, const size_t size) {
 		auto& target = packets[pack->header];
 		if (target) return false;
@@ -71,9 +79,37 @@ struct PacketPart {
 		target = pack;
 		totalSize += size;
 		--left;
+
+		if (pack->header == this->size - 1)
+			lastSize = size;
+
 		return true;
 	}
 
+	size_t partSize(size_t index) const { return index == size - 1 ? lastSize : (size_t)max_length; }
+
+	// Calls f(index, data, size) for the fragments continuing the in-order prefix
+	template <typename F>
+	void passReady(F f) {
+		for (; passed < size && packets[passed]; ++passed)
+			f(passed, packets[passed]->data, partSize(passed));
+	}
+
+	// Copies the payload of the complete sequence to out, returns its size
+	size_t combine(char* out) const {
+		PacketPtr* last = packets + size - 1;
+		size_t total = totalSize;
+
+		for (PacketPtr* ptr = packets; ptr != last; ++ptr) {
+			memcpy(out, (*ptr)->data, max_length);
+			total -= max_length;
+			out += max_length;
+		}
+
+		memcpy(out, (*last)->data, total);
+		return totalSize;
+	}
+
 	void clear() {
 		PacketPtr* end = packets + size;
 		for (PacketPtr* ptr = packets; ptr != end; ++ptr)
@@ -92,6 +128,7 @@ public:
 	}
 
 	~PacketCollector() {
+		map_.clear();  // Parts release their packets from the sequences memory
 		free(sequences);
 	}
 
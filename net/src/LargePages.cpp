@@ -0,0 +1,117 @@
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "net/LargePages.hpp"
+#include "net/Logger.hpp"
+
+const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+static const char* BACKING_NAMES[] = { "regular", "transparent", "explicit" };
+
+static size_t roundToHugePages(size_t size) {
+	return (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+LargeBuffer::LargeBuffer(size_t size, PageBacking wanted) {
+#ifdef __linux__
+	if (wanted == PageBacking::Explicit) {
+		const size_t rounded = roundToHugePages(size);
+		void* place = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (place != MAP_FAILED) {
+			data_ = (char*)place;
+			size_ = rounded;
+			backing_ = PageBacking::Explicit;
+			return;
+		}
+
+		LOG_WARN("No reserved huge pages for " << rounded << " bytes, trying the transparent ones");
+		wanted = PageBacking::Transparent;
+	}
+
+	if (wanted == PageBacking::Transparent) {
+		const size_t rounded = roundToHugePages(size);
+		void* place = nullptr;
+
+		if (posix_memalign(&place, HUGE_PAGE_SIZE, rounded) == 0) {
+			// Only a hint, the buffer is usable whatever the kernel does with it
+			if (madvise(place, rounded, MADV_HUGEPAGE) != 0)
+				LOG_WARN("Transparent huge pages are not available");
+
+			data_ = (char*)place;
+			size_ = rounded;
+			backing_ = PageBacking::Transparent;
+			return;
+		}
+	}
+#else
+	if (wanted != PageBacking::Regular)
+		LOG_WARN("Huge pages are supported on Linux only");
+#endif
+
+	data_ = (char*)malloc(size);
+	if (!data_) throw std::bad_alloc();
+
+	size_ = size;
+	backing_ = PageBacking::Regular;
+}
+
+LargeBuffer::~LargeBuffer() {
+	release();
+}
+
+LargeBuffer::LargeBuffer(LargeBuffer&& rhs) noexcept : data_(rhs.data_), size_(rhs.size_), backing_(rhs.backing_) {
+	rhs.data_ = nullptr;
+	rhs.size_ = 0;
+}
+
+LargeBuffer& LargeBuffer::operator=(LargeBuffer&& rhs) noexcept {
+	if (this != &rhs) {
+		release();
+
+		data_ = rhs.data_;
+		size_ = rhs.size_;
+		backing_ = rhs.backing_;
+
+		rhs.data_ = nullptr;
+		rhs.size_ = 0;
+	}
+
+	return *this;
+}
+
+void LargeBuffer::release() {
+	if (!data_) return;
+
+#ifdef __linux__
+	if (backing_ == PageBacking::Explicit)
+		munmap(data_, size_);
+	else
+#endif
+		free(data_);
+
+	data_ = nullptr;
+	size_ = 0;
+}
+
+PageBacking LargeBuffer::getBacking(const boost::property_tree::ptree& config, const char* kind) {
+	auto section = config.get_child_optional("hugepages");
+	if (!section) return PageBacking::Regular;
+
+	const std::string name = section->get<std::string>(kind, BACKING_NAMES[(size_t)PageBacking::Regular]);
+	for (size_t i = 0; i < sizeof(BACKING_NAMES) / sizeof(BACKING_NAMES[0]); ++i)
+		if (name == BACKING_NAMES[i]) return (PageBacking)i;
+
+	LOG_WARN("Unknown page backing " << name << " of " << kind << ", using the regular one");
+	return PageBacking::Regular;
+}
+
+const char* LargeBuffer::getBackingName(PageBacking backing) {
+	return BACKING_NAMES[(size_t)backing];
+}
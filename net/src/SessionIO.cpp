@@ -6,6 +6,8 @@
 #include <atomic>
 
 #include <csnode/Node.hpp>
+#include <csnode/PerfCounters.hpp>
+#include <csnode/ThreadTopology.hpp>
 
 #include "net/Logger.hpp"
 #include "net/SessionIO.hpp"
@@ -19,12 +21,17 @@ const unsigned CLOSE_TIMEOUT_SEC = 10;
 
 const unsigned MAX_REDIRECT = 1;
 
+// Fragment number in the duplicates filter keys of the combined messages
+const uint16_t COMBINED_MESSAGE_KEY = 0xFFFF;
+
 std::atomic_bool SessionIO::AwaitingRegistration{true};
 std::function<void(PacketPtr*)> PacketPtr::freeFunc = [](PacketPtr*) { };
 
 using namespace std::placeholders;
 SessionIO::SessionIO() : InputServiceResolver_(io_service_client_), 
-						 OutputServiceResolver_(io_service_client_) {
+						 OutputServiceResolver_(io_service_client_),
+						 m_topology(new Credits::ThreadTopology),
+						 m_stream(io_service_client_) {
 	if (!Initialization()) {
 		std::cerr << "Cannot initialize session due to critical errors. The node will be closed in " << CLOSE_TIMEOUT_SEC << " seconds..." << std::endl;
 		std::this_thread::sleep_for(std::chrono::seconds(CLOSE_TIMEOUT_SEC));
@@ -33,14 +40,12 @@ SessionIO::SessionIO() : InputServiceResolver_(io_service_client_),
 }
 
 SessionIO::~SessionIO() {
-	free(m_combinedData);
-
 	m_taskman.stop();
 	m_senderThread.join();
 }
 
 bool SessionIO::Initialization() {
-	boost::property_tree::ptree config;
+	boost::property_tree::ptree& config = m_config;
 	boost::property_tree::read_ini("Configure.ini", config);
 
 	// Setting the network
@@ -66,14 +71,38 @@ bool SessionIO::Initialization() {
 
 	signalServerAddr = OutputServiceServerEndpoint_.address();
 
+	// Optional traffic impairment, used to benchmark the retransmission settings
+	m_outFaults.load(config, "faultsOut");
+	m_inFaults.load(config, "faultsIn");
+
+	if (auto observer = config.get_child_optional("observer")) {
+		m_observer = observer->get<bool>("enabled", m_observer);
+		m_observerRedirect = observer->get<bool>("redirect", m_observerRedirect);
+	}
+
+	// The threads started from now on inherit the placement of this one
+	if (m_topology->load(config))
+		m_topology->applyToCurrent(Credits::ThreadRole::Other);
+
+	// Before the threads of the node, every one opens the counters of its own
+	Credits::PerfCounters::load(config);
 
 	// Initialize resources
-	m_combinedData = (char*)malloc(MAX_PART * max_length);
-	if (!m_combinedData) return false;
+	m_pacman.setBacking(LargeBuffer::getBacking(config, "packets"));
+	m_combinedData = LargeBuffer(MAX_PART * max_length, LargeBuffer::getBacking(config, "reassembly"));
 
 	MyIp_ = InputServiceRecvEndpoint_.address();
 	if (!GenerationHash()) return false;
 
+	if (m_stream.load(config, MyIp_))
+		m_stream.start(
+			[this](const Packet& header, const char* data, std::size_t size, const ip::address& sender) {
+				StreamHandleReceive(header, data, size, sender);
+			},
+			[this](std::vector<PacketPtr>&& packets, std::size_t lastSize, const ip::address& peer) {
+				m_taskman.add(Task(std::move(packets), lastSize, udp::endpoint(peer, nodePort)));
+			});
+
 	node_ = std::make_unique<Credits::Node>(MyIp_, MyPublicKey_, this);
 	if (!node_ || !node_->isGood()) return false;
 
@@ -137,18 +166,28 @@ void SessionIO::StartReceive() {
 			InputServiceSendEndpoint_,
 			[this, nextPack] (const boost::system::error_code& error, std::size_t bytes_transferred) {
 				LOG_IN_PACK(nextPack, bytes_transferred);
-				InputServiceHandleReceive(nextPack, error, bytes_transferred);
+
+				// The signal server is not impaired, as on the way out
+				if (!error && m_inFaults.enabled() && InputServiceSendEndpoint_.address() != signalServerAddr)
+					m_inFaults.process(nextPack, bytes_transferred, InputServiceSendEndpoint_,
+						[this](PacketPtr pack, std::size_t size, const udp::endpoint& sender) {
+							InputServiceHandleReceive(pack, boost::system::error_code(), size, sender);
+						});
+				else
+					InputServiceHandleReceive(nextPack, error, bytes_transferred, InputServiceSendEndpoint_);
+
 				StartReceive();
 			});
 }
 
-inline void SessionIO::InputServiceHandleReceive(PacketPtr message, const boost::system::error_code& error, std::size_t bytes_transferred) {
+inline void SessionIO::InputServiceHandleReceive(PacketPtr message, const boost::system::error_code& error, std::size_t bytes_transferred, const udp::endpoint& sender) {
 	if (error) {
 		std::cerr << "Receive error: " << error << std::endl;
 		return;
 	}
-	
-	addToRingBuffer(InputServiceSendEndpoint_.address());
+
+	Credits::PerfScope perf(Credits::PerfStage::Receive);
+	addToRingBuffer(sender.address());
 
 	bool multiPack = false;
 	char* dataPtr = message->data;
@@ -162,38 +201,65 @@ inline void SessionIO::InputServiceHandleReceive(PacketPtr message, const boost:
 		if (message->command == CommandList::Redirect)
 			RunRedirect(message, size);
 
+		Credits::PerfScope reassembly(Credits::PerfStage::Reassemble);
+		// The repeats of a complete message go on, it is taken again when it was
+		// dropped and forgotten
 		auto packResult = m_packets.append(message, size);
-		if (!packResult.second) return;
+		if (!packResult.second && packResult.first->left != 0) return;
 
-		if (packResult.first->left != 0) return;
+		// Blocks are read while their fragments arrive
+		if (message->command == CommandList::Redirect && message->subcommand == SubCommandList::GetBlock) {
+			const Hash key(message->HashBlock);
+			const size_t count = message->countHeader;
 
-		// Ok, we can combine, since left = 0
-		PacketPtr* last = packResult.first->packets + message->countHeader - 1;
-		char* writePtr = m_combinedData;
-		size_t total = packResult.first->totalSize;
-		for (PacketPtr* ptr = packResult.first->packets; ptr != last; ++ptr) {
-			memcpy(writePtr, (*ptr)->data, max_length);
-			total -= max_length;
-			writePtr += max_length;
+			packResult.first->passReady([this, &key, count](size_t index, const char* data, size_t size) {
+				node_->getBlockFragment(key, index, count, data, size);
+			});
 		}
 
-		memcpy(writePtr, (*last)->data, total);
+		if (packResult.first->left != 0) return;
+
+		// It may have come by stream already, or be a repeat of a complete one
+		if (!isNewMessage(*message)) return;
 
+		// Ok, we can combine, since left = 0
 		multiPack = true;
-		dataPtr = m_combinedData;
-		size = packResult.first->totalSize;
+		dataPtr = m_combinedData.data();
+		size = packResult.first->combine(m_combinedData.data());
 	}
 
 	if (message->command != CommandList::Redirect && getBackDataCounter(message) > 1)
 		return;
 
-	switch (message->command) {
+	if (message->command == CommandList::Redirect && !multiPack && !RunRedirect(message, size))
+		return;
+
+	processMessage(*message, dataPtr, size);
+}
+
+/* The sender reaches every node of its ring by stream, so these messages are not
+   redirected further */
+void SessionIO::StreamHandleReceive(const Packet& header, const char* data, std::size_t size, const ip::address& sender) {
+	addToRingBuffer(sender);
+
+	if (!isNewMessage(header)) return;
+
+	processMessage(header, data, size);
+}
+
+inline void SessionIO::processMessage(const Packet& message, const char* dataPtr, std::size_t size) {
+	if (m_observer && !isObserved(message)) return;
+
+	// Taken when sent again, the node has room by then
+	if (!node_->admitMessage()) {
+		forgetMessage(message);
+		return;
+	}
+
+	switch (message.command) {
 		case CommandList::Redirect:	
 		{
-			if (!multiPack && !RunRedirect(message, size))
-				return;
-
-			switch (message->subcommand) {
+			switch (message.subcommand) {
 				case SubCommandList::SGetIpTable:
 				{
 					node_->getRoundTable(dataPtr, size);
@@ -201,13 +267,13 @@ inline void SessionIO::InputServiceHandleReceive(PacketPtr message, const boost:
 				}
 				case SubCommandList::GetBlock:
 				{
-					node_->getBlock(dataPtr, size, ip::make_address_v4(message->origin_ip));
+					node_->getBlock(dataPtr, size, ip::make_address_v4(message.origin_ip), Hash(message.HashBlock));
 					break;
 				}
 				case SubCommandList::RegistrationLevelNode: { break; }
 				default:
 				{
-					LOG_WARN("Unknown command received: " << (int)message->command << ":" << (int)message->subcommand << " from " << ip::make_address_v4(message->origin_ip));
+					LOG_WARN("Unknown command received: " << (int)message.command << ":" << (int)message.subcommand << " from " << ip::make_address_v4(message.origin_ip));
 					break;
 				}
 			}
@@ -218,6 +284,21 @@ inline void SessionIO::InputServiceHandleReceive(PacketPtr message, const boost:
 			node_->getTransactionsList(dataPtr, size);
 			break;
 		}
+		case CommandList::GetCompactCandidate:
+		{
+			node_->getCompactTransactionsList(dataPtr, size, ip::make_address_v4(message.origin_ip));
+			break;
+		}
+		case CommandList::GetCandidateRequest:
+		{
+			node_->getCandidateRequest(dataPtr, size, ip::make_address_v4(message.origin_ip));
+			break;
+		}
+		case CommandList::GetCandidateTransactions:
+		{
+			node_->getCandidateTransactions(dataPtr, size);
+			break;
+		}
 		case CommandList::GetTransaction:
 		{
 			node_->getTransaction(dataPtr, size);
@@ -230,23 +311,23 @@ inline void SessionIO::InputServiceHandleReceive(PacketPtr message, const boost:
 		}
 		case CommandList::GetVector:
 		{
-			node_->getVector(dataPtr, size, ip::make_address_v4(message->origin_ip));
+			node_->getVector(dataPtr, size, ip::make_address_v4(message.origin_ip));
 			break;
 		}
 		case CommandList::GetMatrix:
 		{
-			node_->getMatrix(dataPtr, size, ip::make_address_v4(message->origin_ip));
+			node_->getMatrix(dataPtr, size, ip::make_address_v4(message.origin_ip));
 			break;
 		}
 		case CommandList::GetHash:
 		{
-			node_->getHash(dataPtr, size, ip::make_address_v4(message->origin_ip));
+			node_->getHash(dataPtr, size, ip::make_address_v4(message.origin_ip));
 			break;
 		}
 		case CommandList::SinhroPacket: { break; }
 		default:
 		{
-			LOG_WARN("Unknown command received: " << (int)message->command << ":" << (int)message->subcommand << " from " << ip::make_address_v4(message->origin_ip));
+			LOG_WARN("Unknown command received: " << (int)message.command << ":" << (int)message.subcommand << " from " << ip::make_address_v4(message.origin_ip));
 			break;
 		}
 	}
@@ -260,6 +341,9 @@ inline bool SessionIO::RunRedirect(PacketPtr message, std::size_t dataSize) {
 	if (counter > MAX_REDIRECT)
 		return needProcessing;
 
+	if (m_observer && (!m_observerRedirect || !isObserved(*message)))
+		return needProcessing;
+
 	memcpy(message->hash, MyHash_.str, hash_length);
 	memcpy(message->publicKey, MyPublicKey_.str, publicKey_length);
 
@@ -269,18 +353,54 @@ inline bool SessionIO::RunRedirect(PacketPtr message, std::size_t dataSize) {
 }
 
 inline uint32_t SessionIO::getBackDataCounter(PacketPtr message) {
-	Hash key{ message->HashBlock };
-	*((uint16_t*)(key.str)) = message->header;
+	return getBackDataCounter(message->HashBlock, message->header);
+}
+
+inline uint32_t SessionIO::getBackDataCounter(const char* hashBlock, const uint16_t header) {
+	Hash key{ hashBlock };
+	*((uint16_t*)(key.str)) = header;
 
 	return m_backData.pushAndIncrease(key);
 }
 
+inline bool SessionIO::isObserved(const Packet& message) const {
+	return message.command == CommandList::Redirect &&
+		(message.subcommand == SubCommandList::GetBlock || message.subcommand == SubCommandList::SGetIpTable);
+}
+
+// Single packets share the key with their only fragment
+inline bool SessionIO::isNewMessage(const Packet& header) {
+	return getBackDataCounter(header.HashBlock, header.countHeader > 0 ? COMBINED_MESSAGE_KEY : 0) == 1;
+}
+
+inline void SessionIO::forgetMessage(const Packet& header) {
+	Hash key{ header.HashBlock };
+
+	*((uint16_t*)(key.str)) = header.header;
+	m_backData.erase(key);
+
+	if (header.countHeader > 0) {
+		*((uint16_t*)(key.str)) = COMBINED_MESSAGE_KEY;
+		m_backData.erase(key);
+	}
+}
+
 void SessionIO::addToRingBuffer(const boost::asio::ip::address& addr) {
 	udp::endpoint regEndPoint(addr, addr == signalServerAddr ? signalServerPort : nodePort);
 	bool addedNew = m_nodesRing.place(std::move(regEndPoint));
 	if (addedNew) SendGreetings();
 }
 
+std::vector<ip::address> SessionIO::getRingAddresses() const {
+	std::vector<ip::address> result;
+	result.reserve(m_nodesRing.getEndPoints().size());
+
+	for (auto& ep : m_nodesRing.getEndPoints())
+		result.push_back(ep.address());
+
+	return result;
+}
+
 TaskId SessionIO::addTaskDirect(std::vector<PacketPtr>&& packets, const CommandList cmd, const SubCommandList subcmd, const size_t lastSize, const ip::address& ip) {
 	createSendTasks(packets, cmd, subcmd, lastSize);
 	udp::endpoint regEndPoint(ip, ip == signalServerAddr ? signalServerPort : nodePort);
@@ -296,6 +416,39 @@ TaskId SessionIO::addTaskBroadcast(std::vector<PacketPtr>&& packets, const SubCo
 	return m_taskman.add(std::move(t));
 }
 
+void SessionIO::sendBulkDirect(std::vector<PacketPtr>&& packets, const CommandList cmd, const SubCommandList subcmd, const size_t lastSize, const ip::address& ip) {
+	if (!isBulk(packets, lastSize) || ip == signalServerAddr) {
+		addTaskDirect(std::move(packets), cmd, subcmd, lastSize, ip);
+		return;
+	}
+
+	createSendTasks(packets, cmd, subcmd, lastSize);
+
+	if (!m_stream.send(ip, packets, lastSize))
+		m_taskman.add(Task(std::move(packets), lastSize, udp::endpoint(ip, nodePort)));
+}
+
+void SessionIO::sendBulkBroadcast(std::vector<PacketPtr>&& packets, const SubCommandList subcmd, const size_t lastSize) {
+	if (!isBulk(packets, lastSize)) {
+		addTaskBroadcast(std::move(packets), subcmd, lastSize);
+		return;
+	}
+
+	createSendTasks(packets, CommandList::Redirect, subcmd, lastSize);
+
+	std::deque<udp::endpoint> udpReceivers;
+	for (auto& ep : m_nodesRing.getEndPoints())
+		if (ep.address() == signalServerAddr || !m_stream.send(ep.address(), packets, lastSize))
+			udpReceivers.push_back(ep);
+
+	if (!udpReceivers.empty())
+		m_taskman.add(Task(std::move(packets), lastSize, udpReceivers));
+}
+
+inline bool SessionIO::isBulk(const std::vector<PacketPtr>& packets, const size_t lastSize) const {
+	return m_stream.enabled() && !packets.empty() && (packets.size() - 1) * max_length + lastSize >= m_stream.getThreshold();
+}
+
 inline void SessionIO::createSendTasks(const std::vector<PacketPtr>& packets, const CommandList cmd, const SubCommandList subcmd, const size_t lastSize) {
 	if (packets.empty()) return;
 
@@ -336,6 +489,17 @@ inline void SessionIO::outSendPack(PacketPtr message, std::size_t dataSize, cons
 }
 
 inline void SessionIO::handleSend(PacketPtr message, std::size_t size_pck, const udp::endpoint& endpoint) {
+	// The signal server traffic goes from the registration thread, keep it clean
+	if (m_outFaults.enabled() && endpoint.address() != signalServerAddr) {
+		m_outFaults.process(message, size_pck, endpoint,
+			[this](PacketPtr pack, std::size_t size, const udp::endpoint& ep) { sendPack(pack, size, ep); });
+		return;
+	}
+
+	sendPack(message, size_pck, endpoint);
+}
+
+inline void SessionIO::sendPack(PacketPtr message, std::size_t size_pck, const udp::endpoint& endpoint) {
 	OutputServiceSocket_->async_send_to(boost::asio::buffer((char*)message.get(), size_pck),
 		endpoint,
 		boost::bind(&SessionIO::outputHandleSend, this, message,
@@ -350,6 +514,16 @@ void SessionIO::outputHandleSend(PacketPtr message, const boost::system::error_c
 	}
 }
 
+inline void SessionIO::flushFaults() {
+	if (m_outFaults.enabled())
+		m_outFaults.flush([this](PacketPtr pack, std::size_t size, const udp::endpoint& ep) { sendPack(pack, size, ep); });
+
+	if (m_inFaults.enabled())
+		m_inFaults.flush([this](PacketPtr pack, std::size_t size, const udp::endpoint& sender) {
+			InputServiceHandleReceive(pack, boost::system::error_code(), size, sender);
+		});
+}
+
 void SessionIO::senderThreadRoutine() {
 	m_taskman.run([this] (const Task& task) {
 		size_t cntr = 0;
@@ -367,7 +541,7 @@ inline void SessionIO::RegistrationToServer() {
 		std::string version = std::to_string(CURRENT_VERSION);
 		auto pack = m_pacman.getFreePack();
 		memcpy(pack->data, version.c_str(), version.size());
-		outFrmPack(pack, CommandList::Registration, SubCommandList::Empty, Version::version_1, version.size());
+		outFrmPack(pack, CommandList::Registration, m_observer ? SubCommandList::RegistrationLevelObserver : SubCommandList::Empty, Version::version_1, version.size());
 		outSendPack(pack, version.size(), &OutputServiceServerEndpoint_);
 		std::this_thread::sleep_for(std::chrono::seconds(5));
 	}
@@ -411,10 +585,13 @@ bool SessionIO::GenerationHash() {
 
 void SessionIO::Run() {
 	InitConnection();
+	m_topology->applyToCurrent(Credits::ThreadRole::Network);
 
 	while (true) {
 		io_service_client_.poll();
+		node_->processPipeline();
 		senderThreadRoutine();
+		flushFaults();
 	}
 }
 
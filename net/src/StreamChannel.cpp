@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+
+#include "net/Logger.hpp"
+#include "net/SessionIO.hpp"
+#include "net/StreamChannel.hpp"
+
+const uint32_t STREAM_MAGIC = 0x54534343;  // "CCST"
+
+const auto STREAM_CONNECT_TIMEOUT = std::chrono::seconds(2);
+const auto STREAM_REFUSE_TIMEOUT = std::chrono::seconds(60);
+const auto STREAM_READ_TIMEOUT = std::chrono::seconds(5);
+
+const uint32_t MAX_FRAME_SIZE = Packet::headerLength() + MAX_PART * max_length;
+
+StreamChannel::StreamChannel(io_service& service) : service_(service) { }
+
+StreamChannel::~StreamChannel() {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+	if (unixAcceptor_)
+		std::remove(getSocketPath(myIp_).c_str());
+#endif
+}
+
+bool StreamChannel::load(const boost::property_tree::ptree& config, const ip::address& myIp) {
+	auto section = config.get_child_optional("stream");
+	if (!section) return false;
+
+	myIp_ = myIp;
+	port_ = section->get<unsigned short>("port", port_);
+	threshold_ = section->get<std::size_t>("threshold", threshold_);
+	maxQueued_ = std::max<std::size_t>(section->get<std::size_t>("maxQueued", maxQueued_), 1);
+	maxPending_ = std::max<std::size_t>(section->get<std::size_t>("maxPending", maxPending_), 1);
+	unixSocketDir_ = section->get<std::string>("unixSocketDir", "");
+
+#ifndef BOOST_ASIO_HAS_LOCAL_SOCKETS
+	if (!unixSocketDir_.empty()) {
+		LOG_WARN("No local sockets on this system, co-located nodes will use TCP");
+		unixSocketDir_.clear();
+	}
+#endif
+
+	enabled_ = true;
+	return true;
+}
+
+bool StreamChannel::start(Handler handler, Fallback fallback) {
+	if (!enabled_) return false;
+
+	handler_ = handler;
+	fallback_ = fallback;
+
+	if (!listen(tcpAcceptor_, ip::tcp::endpoint(myIp_, port_))) {
+		enabled_ = false;
+		return false;
+	}
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+	if (!unixSocketDir_.empty()) {
+		const auto path = getSocketPath(myIp_);
+		std::remove(path.c_str());  // Left by a crashed run
+
+		if (!listen(unixAcceptor_, local::stream_protocol::endpoint(path)))
+			unixSocketDir_.clear();
+	}
+#endif
+
+	return true;
+}
+
+bool StreamChannel::listen(std::unique_ptr<Acceptor>& acceptor, const Protocol::endpoint& ep) {
+	boost::system::error_code ec;
+
+	acceptor.reset(new Acceptor(service_));
+	acceptor->open(ep.protocol(), ec);
+	if (!ec && ep.protocol().family() != AF_UNIX)
+		acceptor->set_option(socket_base::reuse_address(true), ec);
+	if (!ec) acceptor->bind(ep, ec);
+	if (!ec) acceptor->listen(socket_base::max_connections, ec);
+
+	if (ec) {
+		LOG_ERROR("Cannot listen for streams: " << ec.message());
+		acceptor.reset();
+		return false;
+	}
+
+	accept(*acceptor);
+	return true;
+}
+
+void StreamChannel::accept(Acceptor& acceptor) {
+	auto conn = std::make_shared<Incoming>(service_);
+
+	acceptor.async_accept(conn->socket, [this, conn, &acceptor](const boost::system::error_code& ec) {
+		if (ec == error::operation_aborted) return;
+
+		if (!ec) {
+			if (pending_ < maxPending_)
+				readHello(conn);
+			else {
+				LOG_WARN("Too many stream connections in hello, closing");
+				boost::system::error_code ignored;
+				conn->socket.close(ignored);
+			}
+		}
+
+		accept(acceptor);
+	});
+}
+
+void StreamChannel::readHello(IncomingPtr conn) {
+	++pending_;
+	conn->pending = true;
+	setDeadline(conn);
+
+	async_read(conn->socket, buffer(&conn->hello, sizeof(Hello)), [this, conn](const boost::system::error_code& ec, std::size_t) {
+		if (ec || conn->hello.magic != STREAM_MAGIC || conn->hello.version != CURRENT_VERSION) {
+			drop(conn);
+			return;
+		}
+
+		if (!isDeclaredPeer(*conn)) {
+			LOG_WARN("Stream peer declared " << ip::make_address_v4(conn->hello.ip) << " from another address, closing");
+			drop(conn);
+			return;
+		}
+
+		// Same version, answer with ours
+		auto reply = std::make_shared<Hello>(Hello{ STREAM_MAGIC, CURRENT_VERSION, myIp_.to_v4().to_uint() });
+		async_write(conn->socket, buffer(reply.get(), sizeof(Hello)), [this, conn, reply](const boost::system::error_code& ec, std::size_t) {
+			if (ec) {
+				drop(conn);
+				return;
+			}
+
+			settle(*conn);
+			readFrame(conn);
+		});
+	});
+}
+
+bool StreamChannel::isDeclaredPeer(const Incoming& conn) const {
+	boost::system::error_code ec;
+	const auto remote = conn.socket.remote_endpoint(ec);
+	if (ec) return false;
+
+	// Only the co-located nodes reach the local socket
+	if (remote.protocol().family() == AF_UNIX) return true;
+	if (remote.protocol().family() != AF_INET) return false;
+
+	ip::tcp::endpoint tcp;
+	tcp.resize(remote.size());
+	memcpy(tcp.data(), remote.data(), remote.size());
+
+	return tcp.address() == ip::make_address_v4(conn.hello.ip);
+}
+
+void StreamChannel::readFrame(IncomingPtr conn) {
+	// Idle between the frames as long as the sender keeps the connection
+	async_read(conn->socket, buffer(&conn->frameSize, sizeof(conn->frameSize)), [this, conn](const boost::system::error_code& ec, std::size_t) {
+		if (ec) {
+			drop(conn);
+			return;
+		}
+
+		if (conn->frameSize <= Packet::headerLength() || conn->frameSize > MAX_FRAME_SIZE) {
+			LOG_WARN("Bad stream frame of " << conn->frameSize << " bytes from " << ip::make_address_v4(conn->hello.ip));
+			drop(conn);
+			return;
+		}
+
+		conn->frame.resize(conn->frameSize);
+		setDeadline(conn);
+
+		async_read(conn->socket, buffer(conn->frame), [this, conn](const boost::system::error_code& ec, std::size_t) {
+			if (ec) {
+				drop(conn);
+				return;
+			}
+
+			settle(*conn);
+
+			const Packet& header = *(const Packet*)conn->frame.data();
+			handler_(header, conn->frame.data() + Packet::headerLength(), conn->frame.size() - Packet::headerLength(), ip::make_address_v4(conn->hello.ip));
+
+			readFrame(conn);
+		});
+	});
+}
+
+void StreamChannel::setDeadline(IncomingPtr conn) {
+	conn->timer.expires_from_now(STREAM_READ_TIMEOUT);
+	conn->timer.async_wait([conn](const boost::system::error_code& ec) {
+		// Not reset or cancelled since
+		if (ec || conn->timer.expires_at() > steady_timer::clock_type::now()) return;
+
+		boost::system::error_code ignored;
+		conn->socket.close(ignored);
+	});
+}
+
+void StreamChannel::settle(Incoming& conn) {
+	// Cancels the wait, also one already done that is yet to run
+	conn.timer.expires_at(steady_timer::time_point::max());
+
+	if (conn.pending) {
+		conn.pending = false;
+		--pending_;
+	}
+}
+
+void StreamChannel::drop(IncomingPtr conn) {
+	settle(*conn);
+
+	boost::system::error_code ignored;
+	conn->socket.close(ignored);
+}
+
+bool StreamChannel::send(const ip::address& peer, const std::vector<PacketPtr>& packets, std::size_t lastSize) {
+	if (!enabled_ || packets.empty()) return false;
+
+	auto refused = refused_.find(peer);
+	if (refused != refused_.end()) {
+		if (refused->second > Clock::now()) return false;
+		refused_.erase(refused);
+	}
+
+	auto& conn = outgoing_[peer];
+	const bool isNew = !conn;
+	if (isNew) conn = std::make_shared<Outgoing>(service_);
+	else if (conn->queue.size() >= maxQueued_) return false;
+
+	const uint32_t frameSize = (uint32_t)(Packet::headerLength() + (packets.size() - 1) * max_length + lastSize);
+	conn->queue.push_back(Message{ packets, lastSize, frameSize });
+
+	if (isNew)
+		connect(peer, conn);
+	else if (conn->ready && !conn->writing)
+		writeNext(peer, conn);
+
+	return true;
+}
+
+void StreamChannel::connect(const ip::address& peer, OutgoingPtr conn) {
+	conn->timer.expires_from_now(STREAM_CONNECT_TIMEOUT);
+	conn->timer.async_wait([conn](const boost::system::error_code& ec) {
+		if (!ec && !conn->ready) {
+			boost::system::error_code ignored;
+			conn->socket.close(ignored);
+		}
+	});
+
+	conn->socket.async_connect(getPeerEndpoint(peer), [this, peer, conn](const boost::system::error_code& ec) {
+		if (ec) {
+			fail(peer, conn, ec);
+			return;
+		}
+
+		conn->hello = Hello{ STREAM_MAGIC, CURRENT_VERSION, myIp_.to_v4().to_uint() };
+		async_write(conn->socket, buffer(&conn->hello, sizeof(Hello)), [this, peer, conn](const boost::system::error_code& ec, std::size_t) {
+			if (ec) {
+				fail(peer, conn, ec);
+				return;
+			}
+
+			async_read(conn->socket, buffer(&conn->hello, sizeof(Hello)), [this, peer, conn](const boost::system::error_code& ec, std::size_t) {
+				if (ec || conn->hello.magic != STREAM_MAGIC || conn->hello.version != CURRENT_VERSION) {
+					fail(peer, conn, ec ? ec : error::make_error_code(error::connection_refused));
+					return;
+				}
+
+				conn->timer.cancel();
+				conn->ready = true;
+				writeNext(peer, conn);
+			});
+		});
+	});
+}
+
+void StreamChannel::writeNext(const ip::address& peer, OutgoingPtr conn) {
+	if (conn->queue.empty()) {
+		conn->writing = false;
+		return;
+	}
+
+	conn->writing = true;
+	Message& msg = conn->queue.front();
+
+	std::vector<const_buffer> buffers;
+	buffers.reserve(msg.packets.size() + 2);
+
+	buffers.push_back(buffer(&msg.frameSize, sizeof(msg.frameSize)));
+	buffers.push_back(buffer((const char*)msg.packets.front().get(), Packet::headerLength()));
+	for (std::size_t i = 0; i < msg.packets.size(); ++i)
+		buffers.push_back(buffer(msg.packets[i]->data, i + 1 == msg.packets.size() ? msg.lastSize : (std::size_t)max_length));
+
+	async_write(conn->socket, buffers, [this, peer, conn](const boost::system::error_code& ec, std::size_t) {
+		if (ec) {
+			fail(peer, conn, ec);
+			return;
+		}
+
+		conn->queue.pop_front();
+		writeNext(peer, conn);
+	});
+}
+
+void StreamChannel::fail(const ip::address& peer, OutgoingPtr conn, const boost::system::error_code& ec) {
+	LOG_WARN("Stream to " << peer << " failed (" << ec.message() << "), using UDP");
+
+	boost::system::error_code ignored;
+	conn->timer.cancel(ignored);
+	conn->socket.close(ignored);
+
+	auto it = outgoing_.find(peer);
+	if (it != outgoing_.end() && it->second == conn) outgoing_.erase(it);
+
+	// A broken connection is reopened on the next send, an unanswered one is not retried for a while
+	if (!conn->ready)
+		refused_[peer] = Clock::now() + STREAM_REFUSE_TIMEOUT;
+
+	auto queue = std::move(conn->queue);
+	conn->queue.clear();
+
+	for (auto& msg : queue)
+		fallback_(std::move(msg.packets), msg.lastSize, peer);
+}
+
+StreamChannel::Protocol::endpoint StreamChannel::getPeerEndpoint(const ip::address& peer) const {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+	if (!unixSocketDir_.empty()) {
+		const auto path = getSocketPath(peer);
+
+		boost::system::error_code ec;
+		if (boost::filesystem::exists(path, ec))
+			return local::stream_protocol::endpoint(path);
+	}
+#endif
+
+	return ip::tcp::endpoint(peer, port_);
+}
+
+std::string StreamChannel::getSocketPath(const ip::address& ip) const {
+	return unixSocketDir_ + "/" + ip.to_string() + ".sock";
+}
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <csdb/pool.h>
+#include <csdb/pool_view.h>
+#include <csdb/storage.h>
+
+#include <csnode/Blockchain.hpp>
+#include <csnode/Pipeline.hpp>
+#include <csnode/SignatureVerifier.hpp>
+
+/* Replays a chain from an existing database through the path the blocks take in the
+   node, without the network: every block is serialized as it is sent, decoded and
+   checked as the decode workers do, and written by the storage stage of a BlockChain
+   opened on a fresh database. Reports the blocks and transactions per second and the
+   time of every stage. The [verification], [apply] and [snapshot] sections of the
+   config apply as in the node.
+
+   Usage: replay <source db> <destination db> [config.ini] */
+
+using namespace Credits;
+
+const std::chrono::seconds REPORT_INTERVAL(10);
+
+// Blocks queued to the storage stage before the replay waits for it
+const size_t MAX_QUEUED_BLOCKS = 64;
+
+// The bytes of a block as the writer sends them
+class BufferSink : public csdb::internal::byte_sink {
+public:
+	void write(const void* data, size_t size) override {
+		bytes.insert(bytes.end(), (const char*)data, (const char*)data + size);
+	}
+
+	std::vector<char> bytes;
+};
+
+struct ReplayStats {
+	StageStats load;
+	StageStats encode;
+	StageStats decode;
+
+	uint64_t blocks = 0;
+	uint64_t transactions = 0;
+	StageClock::time_point started = StageClock::now();
+};
+
+static void report(ReplayStats& stats, SignatureVerifier& verifier, BlockChain& chain) {
+	const double seconds = std::chrono::duration<double>(StageClock::now() - stats.started).count();
+
+	std::cerr << "Replay | " << stats.blocks << " blocks, " << std::fixed << std::setprecision(1)
+	          << stats.blocks / seconds << " blocks/s, " << stats.transactions / seconds << " transactions/s | ";
+
+	stats.load.report(std::cerr, "load", 0);
+	std::cerr << " | ";
+	stats.encode.report(std::cerr, "encode", 0);
+	std::cerr << " | ";
+	stats.decode.report(std::cerr, "decode", 0);
+
+	if (verifier.isEnabled()) {
+		std::cerr << " | ";
+		verifier.report(std::cerr);
+	}
+
+	std::cerr << " | ";
+	chain.getStorageStage().getStats().report(std::cerr, "storage", chain.getStorageStage().depth());
+	std::cerr << " | ";
+	chain.getBalanceCache().report(std::cerr);
+	std::cerr << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " <source db> <destination db> [config.ini]" << std::endl;
+		return 1;
+	}
+
+	boost::property_tree::ptree config;
+	if (argc > 3)
+		boost::property_tree::read_ini(argv[3], config);
+
+	csdb::Storage source;
+	if (!source.open(argv[1])) {
+		std::cerr << "Couldn't open " << argv[1] << ": " << source.last_error_message() << std::endl;
+		return 1;
+	}
+
+	BlockChain chain(argv[2], config);
+	if (!chain.isGood()) return 1;
+
+	if (!chain.getLastHash().is_empty()) {
+		std::cerr << "The destination " << argv[2] << " is not empty" << std::endl;
+		return 1;
+	}
+
+	// The blocks are linked back from the last one
+	std::vector<csdb::PoolHash> hashes;
+	for (csdb::PoolHash hash = source.last_hash(); !hash.is_empty();) {
+		size_t count = 0;
+		csdb::Pool meta = source.pool_load_meta(hash, count);
+		if (!meta.is_valid()) {
+			std::cerr << "Couldn't read block " << hash.to_string() << std::endl;
+			return 1;
+		}
+
+		hashes.push_back(hash);
+		hash = meta.previous_hash();
+	}
+
+	std::cerr << "Replaying " << hashes.size() << " blocks from " << argv[1] << " to " << argv[2] << std::endl;
+
+	SignatureVerifier verifier;
+	verifier.start(config);
+	chain.getBalanceCache().start();
+
+	ReplayStats stats;
+	auto lastReport = StageClock::now();
+	BufferSink sink;
+
+	for (auto hash = hashes.rbegin(); hash != hashes.rend(); ++hash) {
+		const auto started = StageClock::now();
+		csdb::Pool pool = source.pool_load(*hash);
+		if (!pool.is_valid()) {
+			std::cerr << "Couldn't load block " << hash->to_string() << std::endl;
+			return 1;
+		}
+
+		const auto loaded = StageClock::now();
+		stats.load.add(started, started, loaded);
+
+		sink.bytes.clear();
+		pool.to_byte_stream(sink);
+
+		const auto encoded = StageClock::now();
+		stats.encode.add(loaded, loaded, encoded);
+
+		csdb::PoolView view;
+		if (!view.parse(sink.bytes.data(), sink.bytes.size()) || view.binary_size() != sink.bytes.size()) {
+			std::cerr << "Couldn't decode block " << hash->to_string() << std::endl;
+			return 1;
+		}
+
+		csdb::Pool decoded = view.to_pool();
+		stats.decode.add(encoded, encoded, StageClock::now());
+
+		if (verifier.isEnabled() && !verifier.verify(decoded)) {
+			std::cerr << "Bad signature in block " << hash->to_string() << std::endl;
+			return 1;
+		}
+
+		stats.transactions += decoded.transactions_count();
+		++stats.blocks;
+
+		// The stage never refuses a block, the replay waits when it falls behind
+		chain.writeLastBlock(std::move(decoded));
+		if (chain.getStorageStage().depth() >= MAX_QUEUED_BLOCKS)
+			chain.getStorageStage().drain();
+
+		if (StageClock::now() - lastReport >= REPORT_INTERVAL) {
+			lastReport = StageClock::now();
+			report(stats, verifier, chain);
+		}
+	}
+
+	chain.getStorageStage().drain();
+	report(stats, verifier, chain);
+
+	return 0;
+}
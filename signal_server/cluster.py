@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Starts a local network: the signal server stand-in and N nodes on loopback.
+
+Every node runs in its own directory under the work dir, with its own
+Configure.ini, PublicKey.txt and database (test_db). SessionIO talks to its
+peers on a fixed port, so node i listens on 127.0.0.i and the signal server on
+127.0.0.254. Linux routes the whole 127.0.0.0/8 to loopback; elsewhere the
+addresses have to be added to the loopback interface first.
+
+After the given duration the processes are stopped and the round and
+throughput metrics are printed. Round times come from the signal server, which
+sees the round table broadcasts; block sizes come from the node logs.
+
+The Thrift API listens on a fixed port on all interfaces, so only the first
+node gets it.
+
+Observer nodes follow the chain without consensus roles; they get the
+addresses after the regular nodes.
+"""
+
+import argparse
+import base64
+import os
+import re
+import signal
+import subprocess
+import sys
+import threading
+import time
+
+SERVER_IP = "127.0.0.254"
+SERVER_PORT = 6000
+
+CONFIG = """[hostInput]
+ip={ip}
+port=9001
+
+[hostOutput]
+ip={ip}
+port=9000
+
+[server]
+ip={server_ip}
+port={server_port}
+"""
+
+OBSERVER_CONFIG = """
+[observer]
+enabled=true
+"""
+
+STREAM_CONFIG = """
+[stream]
+threshold={threshold}
+unixSocketDir={socket_dir}
+"""
+
+ROUND_RE = re.compile(r"^ROUND (\d+) (\d+)")
+NODE_ROUND_RE = re.compile(r"^Round (\d+) started")
+BLOCK_RE = re.compile(r"^Got block of (\d+)")
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p * (len(values) - 1) + 0.5))]
+
+
+class Collector:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.rounds = {}        # round -> ms since the server start
+        self.blocks = {}        # round -> transactions in its block
+
+    def server_line(self, line):
+        m = ROUND_RE.match(line)
+        if m:
+            with self.lock:
+                self.rounds.setdefault(int(m.group(1)), int(m.group(2)))
+
+    def node_reader(self, stream, log):
+        current = 0
+        for raw in stream:
+            line = raw.decode(errors="replace")
+            log.write(line)
+            m = NODE_ROUND_RE.match(line)
+            if m:
+                current = int(m.group(1))
+                continue
+            m = BLOCK_RE.match(line)
+            if m:
+                with self.lock:
+                    count = int(m.group(1))
+                    self.blocks[current] = max(self.blocks.get(current, 0), count)
+
+
+def prepare_node(workdir, index, stream_threshold, observer):
+    path = os.path.join(workdir, "node_%d" % index)
+    os.makedirs(path, exist_ok=True)
+
+    with open(os.path.join(path, "Configure.ini"), "w") as f:
+        f.write(CONFIG.format(ip="127.0.0.%d" % index, server_ip=SERVER_IP, server_port=SERVER_PORT))
+        if stream_threshold is not None:
+            f.write(STREAM_CONFIG.format(threshold=stream_threshold, socket_dir=os.path.abspath(workdir)))
+        if observer:
+            f.write(OBSERVER_CONFIG)
+
+    key_file = os.path.join(path, "PublicKey.txt")
+    if not os.path.exists(key_file):
+        # SessionIO only hashes the 44 characters of the encoded public key
+        with open(key_file, "w") as f:
+            f.write(base64.b64encode(os.urandom(32)).decode())
+
+    return path
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--nodes", type=int, default=4)
+    parser.add_argument("--observers", type=int, default=0, help="nodes that only follow the chain")
+    parser.add_argument("--duration", type=float, default=60, help="seconds to run the network")
+    parser.add_argument("--node-binary", default="runner/client")
+    parser.add_argument("--server-binary", default="signal_server/signal_server")
+    parser.add_argument("--workdir", default="cluster")
+    parser.add_argument("--stream", type=int, metavar="BYTES",
+                        help="send the messages of this size and more over the local stream sockets")
+    args = parser.parse_args()
+
+    if not 4 <= args.nodes or args.observers < 0 or args.nodes + args.observers >= 254:
+        sys.exit("A round needs a main node and three confidants, and at most 253 nodes fit 127.0.0.0/24")
+
+    node_binary = os.path.abspath(args.node_binary)
+    os.makedirs(args.workdir, exist_ok=True)
+
+    collector = Collector()
+    processes = []
+    readers = []
+
+    server = subprocess.Popen([os.path.abspath(args.server_binary), SERVER_IP, str(SERVER_PORT), str(args.nodes)],
+                              stdout=subprocess.PIPE, stderr=open(os.path.join(args.workdir, "signal_server.log"), "w"))
+    processes.append(server)
+
+    def read_server():
+        for raw in server.stdout:
+            collector.server_line(raw.decode(errors="replace"))
+
+    readers.append(threading.Thread(target=read_server, daemon=True))
+
+    for i in range(1, args.nodes + args.observers + 1):
+        path = prepare_node(args.workdir, i, args.stream, i > args.nodes)
+        node = subprocess.Popen([node_binary], cwd=path, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+        processes.append(node)
+        log = open(os.path.join(path, "node.log"), "w")
+        readers.append(threading.Thread(target=collector.node_reader, args=(node.stderr, log), daemon=True))
+
+    for r in readers:
+        r.start()
+
+    try:
+        time.sleep(args.duration)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for p in processes:
+            p.send_signal(signal.SIGTERM)
+        for p in processes:
+            try:
+                p.wait(timeout=10)
+            except subprocess.TimeoutExpired:
+                p.kill()
+
+    with collector.lock:
+        rounds = sorted(collector.rounds.items())
+        blocks = dict(collector.blocks)
+
+    if len(rounds) < 2:
+        print("Network made %d rounds, see the logs in %s" % (len(rounds), args.workdir))
+        return 1
+
+    intervals = [b[1] - a[1] for a, b in zip(rounds, rounds[1:])]
+    elapsed = (rounds[-1][1] - rounds[0][1]) / 1000.0
+    transactions = sum(blocks.get(r, 0) for r, _ in rounds[:-1])
+
+    print("nodes:           %d" % args.nodes)
+    print("rounds:          %d in %.1f s (%.2f per second)" % (len(rounds), elapsed, (len(rounds) - 1) / elapsed))
+    print("round time ms:   p50 %d, p90 %d, p99 %d, max %d" % (
+        percentile(intervals, 0.5), percentile(intervals, 0.9), percentile(intervals, 0.99), max(intervals)))
+    print("blocks seen:     %d, transactions: %d" % (len(blocks), transactions))
+    print("TPS:             %.1f" % (transactions / elapsed))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
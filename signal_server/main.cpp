@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include <net/Packet.hpp>
+#include <net/SessionIO.hpp>
+
+/* Stand-in for the signal server, to run a network on a single host. Nodes register
+   with their version string, and once enough of them are registered every node gets the
+   round table of the first round followed by the addresses of all the nodes. Later
+   registrations get the round table broadcasted most recently by the writers.
+   Observers are in the ring, but never in the first round table and not counted
+   among the nodes to start with.
+
+   SessionIO reaches its peers on a fixed port, so the nodes have to listen on distinct
+   addresses, e.g. 127.0.0.1, 127.0.0.2, ... on loopback.
+
+   Usage: signal_server <ip> [port] [nodes to start with] */
+
+const unsigned short NODE_PORT = 9001;
+const size_t CONFIDANTS_PER_ROUND = 3;
+const size_t DEFAULT_START_NODES = CONFIDANTS_PER_ROUND + 1;
+
+class SignalServer {
+public:
+	SignalServer(io_service& service, const udp::endpoint& ep, const size_t startNodes) :
+		socket_(service, ep),
+		startNodes_(std::max(startNodes, DEFAULT_START_NODES)),
+		in_(new Packet),
+		out_(new Packet),
+		start_(std::chrono::steady_clock::now()) {
+		memset(out_.get(), 0, Packet::headerLength());
+		memcpy(out_->hash, "SIGNAL", 6);
+	}
+
+	void run() {
+		std::cerr << "Signal server on " << socket_.local_endpoint() << ", waiting for " << startNodes_ << " nodes" << std::endl;
+
+		udp::endpoint sender;
+		while (true) {
+			boost::system::error_code ec;
+			const auto received = socket_.receive_from(boost::asio::buffer(in_.get(), sizeof(Packet)), sender, 0, ec);
+
+			if (ec || received < Packet::headerLength()) continue;
+			const auto dataSize = received - Packet::headerLength();
+
+			if (in_->command == CommandList::Registration)
+				onRegistration(sender.address().to_v4(), dataSize, in_->subcommand == SubCommandList::RegistrationLevelObserver);
+			else if (in_->command == CommandList::Redirect && in_->subcommand == SubCommandList::SGetIpTable && in_->countHeader == 0)
+				onRoundTable(dataSize);
+		}
+	}
+
+private:
+	void onRegistration(const ip::address_v4& node, const size_t dataSize, const bool observer) {
+		const std::string version(in_->data, dataSize);
+		if (version != std::to_string(CURRENT_VERSION)) {
+			std::cerr << node << " refused, version " << version << std::endl;
+			send(node, CommandList::RegistrationConnectionRefused, SubCommandList::Empty, 0);
+			return;
+		}
+
+		if (std::find(nodes_.begin(), nodes_.end(), node) == nodes_.end()) {
+			nodes_.push_back(node);
+			if (observer) observers_.push_back(node);
+			std::cerr << node << " registered" << (observer ? " as observer" : "") << " (" << nodes_.size() << " nodes)" << std::endl;
+		}
+
+		if (round_ == 0) {
+			if (nodes_.size() - observers_.size() < startNodes_) return;
+			startNetwork();
+		}
+		else
+			sendRing(node);
+	}
+
+	// The writer of each round broadcasts the next table, we are in the ring too
+	void onRoundTable(const size_t dataSize) {
+		uint32_t round;
+		if (dataSize < sizeof(round)) return;
+
+		memcpy(&round, in_->data, sizeof(round));
+		if (round <= round_) return;
+
+		reportRound(round);
+		round_ = round;
+		roundTable_.assign(in_->data, in_->data + dataSize);
+	}
+
+	void startNetwork() {
+		round_ = 1;
+		roundTable_.clear();
+
+		std::vector<ip::address_v4> consensus;
+		for (auto& node : nodes_)
+			if (std::find(observers_.begin(), observers_.end(), node) == observers_.end())
+				consensus.push_back(node);
+
+		append(round_);
+		append(consensus[0].to_uint());
+		for (size_t i = 1; i <= CONFIDANTS_PER_ROUND; ++i)
+			append(consensus[i].to_uint());
+
+		reportRound(round_);
+
+		for (auto& node : nodes_)
+			sendRing(node);
+	}
+
+	void sendRing(const ip::address_v4& node) {
+		size_t size = roundTable_.size();
+		memcpy(out_->data, roundTable_.data(), size);
+
+		for (auto& n : nodes_) {
+			if (size + sizeof(uint32_t) > max_length) break;
+
+			const uint32_t ip = n.to_uint();
+			memcpy(out_->data + size, &ip, sizeof(ip));
+			size += sizeof(ip);
+		}
+
+		send(node, CommandList::Registration, SubCommandList::RegistrationLevelNode, size);
+	}
+
+	void send(const ip::address_v4& node, const CommandList cmd, const SubCommandList subcmd, const size_t dataSize) {
+		++messageCounter_;
+		memcpy(out_->HashBlock, &messageCounter_, sizeof(messageCounter_));
+
+		out_->command = cmd;
+		out_->subcommand = subcmd;
+		out_->version = Version::version_1;
+		out_->origin_ip = socket_.local_endpoint().address().to_v4().to_uint();
+
+		boost::system::error_code ec;
+		socket_.send_to(boost::asio::buffer((char*)out_.get(), Packet::headerLength() + dataSize), udp::endpoint(node, NODE_PORT), 0, ec);
+
+		if (ec) std::cerr << "Cannot send to " << node << ": " << ec.message() << std::endl;
+	}
+
+	template <typename T>
+	void append(const T& value) {
+		const char* bytes = (const char*)&value;
+		roundTable_.insert(roundTable_.end(), bytes, bytes + sizeof(T));
+	}
+
+	// Machine readable, the cluster launcher collects these
+	void reportRound(const uint32_t round) {
+		const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+		std::cout << "ROUND " << round << " " << ms << std::endl;
+	}
+
+	udp::socket socket_;
+	const size_t startNodes_;
+
+	std::unique_ptr<Packet> in_;
+	std::unique_ptr<Packet> out_;
+	uint32_t messageCounter_ = 0;
+
+	std::vector<ip::address_v4> nodes_;
+	std::vector<ip::address_v4> observers_;
+	uint32_t round_ = 0;
+	std::vector<char> roundTable_;
+
+	std::chrono::steady_clock::time_point start_;
+};
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <ip> [port] [nodes to start with]" << std::endl;
+		return 1;
+	}
+
+	const unsigned short port = argc > 2 ? (unsigned short)std::stoi(argv[2]) : 6000;
+	const size_t startNodes = argc > 3 ? std::stoul(argv[3]) : DEFAULT_START_NODES;
+
+	io_service service;
+	SignalServer server(service, udp::endpoint(ip::make_address_v4(argv[1]), port), startNodes);
+	server.run();
+
+	return 0;
+}